@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Compact uint8 board with the kernels match-3 and board games run every turn.
+// Value 0 means empty. Row 0 is the top row, gravity pulls towards the last row.
+// All coordinates are 0-based, results are appended to caller-owned vectors.
+class BoardGrid
+{
+public:
+    BoardGrid(int cols, int rows);
+
+    int cols() const { return cols_; }
+    int rows() const { return rows_; }
+
+    // Out-of-range reads return 0, writes are ignored
+    uint8_t get(int col, int row) const;
+    void set(int col, int row, uint8_t value);
+    void fill(uint8_t value);
+    bool swap(int col1, int row1, int col2, int row2);
+
+    // Maximal horizontal and vertical runs of equal non-zero cells with length >= minLen.
+    // Appends [col, row, length, direction] per run, direction 0 = horizontal, 1 = vertical.
+    int findRuns(int minLen, std::vector<int> &out) const;
+
+    // Let non-zero cells fall to the bottom of each column, leaving zeros on top.
+    // Appends [col, fromRow, toRow] per moved cell.
+    int collapseColumns(std::vector<int> &out);
+
+    // Replace the connected region of cells equal to the start cell with newValue.
+    // Returns the number of cells replaced.
+    int floodFill(int col, int row, uint8_t newValue, bool diagonal);
+
+    // Number of 4- (or 8-) connected neighbors equal to value
+    int countNeighbors(int col, int row, uint8_t value, bool diagonal) const;
+
+private:
+    int cols_;
+    int rows_;
+    std::vector<uint8_t> cells_;
+    std::vector<int> stack_; // Flood fill work list, reused
+
+    inline int getCellIndex(int col, int row) const
+    {
+        return row * cols_ + col;
+    }
+
+    inline bool inBounds(int col, int row) const
+    {
+        return col >= 0 && col < cols_ && row >= 0 && row < rows_;
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+enum ColliderShape : uint8_t
+{
+    COLLIDER_CIRCLE,
+    COLLIDER_AABB
+};
+
+struct Collider
+{
+    float x, y; // Circle: center. AABB: top-left corner
+    float w, h; // Circle: w = radius. AABB: size
+    uint16_t category; // Bits this collider belongs to
+    uint16_t mask;     // Bits this collider collides with
+    ColliderShape shape;
+    bool active;
+};
+
+// Broadphase over a uniform grid whose cells are hashed into a fixed number of buckets,
+// so the world has no bounds and memory does not depend on its size.
+// The grid is rebuilt lazily (counting sort by bucket) on the first query after a change.
+// Colliders spanning more than MAX_CELL_SPAN cells per axis (long floors, walls), or lying outside the
+// int16 cell range, are kept out of the grid in a separate list and tested against every collider.
+class CollisionWorld
+{
+public:
+    explicit CollisionWorld(float cellSize);
+
+    // Returns a 0-based collider id. Freed ids are reused.
+    int insertCircle(float x, float y, float r, uint16_t category, uint16_t mask);
+    int insertRect(float x, float y, float w, float h, uint16_t category, uint16_t mask);
+
+    // Move (and optionally resize, when w/h >= 0) a collider. Returns false for an invalid id.
+    bool move(int id, float x, float y, float w = -1.0f, float h = -1.0f);
+    bool remove(int id);
+    bool isValid(int id) const;
+
+    // Ids of colliders overlapping the rectangle
+    void queryRect(float x, float y, float w, float h, std::vector<int> &out);
+
+    // Flat list of colliding id pairs: [a1, b1, a2, b2, ...], each pair reported once
+    void collectPairs(std::vector<int> &out);
+
+    static constexpr int MAX_CELL_SPAN = 32;
+
+private:
+    static constexpr int BUCKET_COUNT = 256; // Power of two
+
+    struct CellEntry
+    {
+        int collider;
+        int16_t cellX, cellY;
+    };
+
+    float cellSize_;
+    float invCellSize_;
+
+    std::vector<Collider> colliders_;
+    std::vector<int> freeIds_;
+
+    // Grid, rebuilt when dirty_ is set
+    bool dirty_;
+    std::vector<CellEntry> entries_;      // Sorted by bucket
+    std::vector<CellEntry> unsorted_;     // Scratch for the counting sort
+    std::vector<int> large_;              // Colliders kept out of the grid, ascending ids
+    std::vector<int> bucketStart_;        // BUCKET_COUNT + 1 offsets into entries_
+    std::vector<uint32_t> queryStamp_;    // Per collider, dedupes multi-cell hits in queries
+    uint32_t stamp_;
+
+    int allocate(const Collider &c);
+    void rebuild();
+
+    inline int cellCoord(float v) const
+    {
+        float c = v * invCellSize_;
+        int i = (int)c;
+        return (c < i) ? i - 1 : i; // floor
+    }
+
+    // Cell range of a box. False when it spans more than MAX_CELL_SPAN cells per axis
+    // or leaves the int16 cell range (also for NaN), the grid can't hold it then.
+    bool cellRange(float x1, float y1, float x2, float y2, int &cx1, int &cy1, int &cx2, int &cy2) const;
+
+    static inline int bucketOf(int cx, int cy)
+    {
+        return (int)(((uint32_t)cx * 73856093u) ^ ((uint32_t)cy * 19349663u)) & (BUCKET_COUNT - 1);
+    }
+
+    static void bounds(const Collider &c, float &x1, float &y1, float &x2, float &y2);
+    static bool overlaps(const Collider &a, const Collider &b);
+};
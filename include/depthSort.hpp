@@ -0,0 +1,19 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Back-to-front ordering of visible faces for the painter's algorithm.
+// Depths are quantized to 16-bit keys over the frame's [minZ, maxZ] range and sorted
+// with a two-pass LSD radix sort (8 bits per pass) on a compact index array, so the
+// face attributes themselves never move. The sort is stable: equal keys keep input order.
+class DepthSorter
+{
+public:
+    // Sort `count` depths far to near. Returns `count` indices into `depth`, valid until the next call.
+    const uint16_t *sortDescending(const float *depth, int count);
+
+private:
+    std::vector<uint16_t> keys_;
+    std::vector<uint16_t> order_;
+    std::vector<uint16_t> scratch_;
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// Sine and cosine from a quarter-wave table with linear interpolation, several times cheaper than libm
+// on the ESP32 (no double math, no range reduction loop). Angles are in radians. The absolute error is
+// below 1e-5 within +-100 and grows to 1e-4 at +-FAST_TRIG_RANGE as the float phase gets coarser,
+// far finer than the renderer or the particle system can show; larger angles fall back to libm.
+static constexpr float FAST_TRIG_RANGE = 1024.0f;
+
+// sin(i * pi / 512) for i = 0..256, one quarter of a wave
+extern const float SINE_QUARTER_TABLE[257];
+
+// Phase in table steps (1024 per turn) split into a whole step and the fraction towards the next
+static inline float fastSinPhase(int32_t step, float fraction)
+{
+    int32_t k = step & 255;
+    int32_t quadrant = (step >> 8) & 3;
+
+    // Quadrants 1 and 3 read the quarter wave backwards
+    float a, b;
+    if (quadrant & 1)
+    {
+        a = SINE_QUARTER_TABLE[256 - k];
+        b = SINE_QUARTER_TABLE[255 - k];
+    }
+    else
+    {
+        a = SINE_QUARTER_TABLE[k];
+        b = SINE_QUARTER_TABLE[k + 1];
+    }
+
+    float v = a + (b - a) * fraction;
+    return (quadrant & 2) ? -v : v;
+}
+
+// Whole table steps and fraction of an angle (floor without a libm call)
+static inline int32_t fastTrigSteps(float angle, float &fraction)
+{
+    float t = angle * (512.0f / 3.14159265f);
+    int32_t i = (int32_t)t;
+    if (t < (float)i)
+        --i;
+    fraction = t - (float)i;
+    return i;
+}
+
+static inline float fastSin(float angle)
+{
+    if (!(std::fabs(angle) < FAST_TRIG_RANGE))
+        return std::sin(angle);
+
+    float fraction;
+    int32_t step = fastTrigSteps(angle, fraction);
+    return fastSinPhase(step, fraction);
+}
+
+static inline float fastCos(float angle)
+{
+    if (!(std::fabs(angle) < FAST_TRIG_RANGE))
+        return std::cos(angle);
+
+    // cos(a) = sin(a + pi / 2), a quarter turn is 256 steps
+    float fraction;
+    int32_t step = fastTrigSteps(angle, fraction);
+    return fastSinPhase(step + 256, fraction);
+}
+
+// Both at once, sharing the range reduction
+static inline void fastSinCos(float angle, float &s, float &c)
+{
+    if (!(std::fabs(angle) < FAST_TRIG_RANGE))
+    {
+        s = std::sin(angle);
+        c = std::cos(angle);
+        return;
+    }
+
+    float fraction;
+    int32_t step = fastTrigSteps(angle, fraction);
+    s = fastSinPhase(step, fraction);
+    c = fastSinPhase(step + 256, fraction);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+
+// Integer alternative to the float vertex transform and perspective divide of the 3D path.
+// The rotation is held in Q1.15 and applied to the int16 model positions, camera space is Q16.16,
+// and 1/z comes from a 257-entry reciprocal table (linearly interpolated on the normalized depth)
+// followed by a multiply, so a vertex costs integer multiply-adds and no divide.
+// Screen positions come out in the 28.4 subpixels of Rasterizer3D, rounded the same way as toSubpixel.
+class FixedTransform3D
+{
+public:
+    // `rotation` is the row-major 3x4 model-to-camera matrix before scaling (orthonormal 3x3 part,
+    // translation in column 3), `scale` maps int16 positions to camera units. `extent` bounds the
+    // absolute camera coordinates of every vertex. Returns false when the instance doesn't fit Q16.16.
+    bool setup(const float rotation[12], float scale, float extent, float fov, float centerX, float centerY,
+               float nearZ);
+
+    // Transforms one int16 position. Always writes the camera depth; returns false (screen untouched)
+    // when the vertex is in front of the near plane or its screen position doesn't fit 16 bits.
+    inline bool transform(const int16_t v[3], float &cameraZ, int16_t screen[2]) const
+    {
+        // Rows of a rotation have unit length, so each sum stays within sqrt(3) * 2^15 * 2^15 < 2^31
+        int32_t rx = rot_[0] * v[0] + rot_[1] * v[1] + rot_[2] * v[2];
+        int32_t ry = rot_[3] * v[0] + rot_[4] * v[1] + rot_[5] * v[2];
+        int32_t rz = rot_[6] * v[0] + rot_[7] * v[1] + rot_[8] * v[2];
+
+        int32_t z = (int32_t)(((int64_t)rz * scale_) >> scaleShift_) + translation_[2];
+        cameraZ = z * (1.0f / 65536.0f);
+        if (z < nearZ_)
+            return false;
+
+        int32_t x = (int32_t)(((int64_t)rx * scale_) >> scaleShift_) + translation_[0];
+        int32_t y = (int32_t)(((int64_t)ry * scale_) >> scaleShift_) + translation_[1];
+
+        // z = m * 2^p with m in [1, 2): 1/z = (1/m) * 2^-p, 1/m from the table in Q1.15
+        int p = 31 - __builtin_clz((uint32_t)z);
+        uint32_t mantissa = ((uint32_t)z >> (p - 16)) & 0xFFFF; // z >= 1.0 in Q16.16, so p >= 16
+        uint32_t i = mantissa >> 8;
+        uint32_t t = mantissa & 0xFF;
+        uint32_t reciprocal = RECIPROCAL[i] - (((RECIPROCAL[i] - RECIPROCAL[i + 1]) * t) >> 8);
+
+        // subpixel = x * fov * 16 / z, rounded half up like Rasterizer3D::toSubpixel
+        int64_t factor = (int64_t)focal_ * reciprocal;
+        int shift = 15 + p + focalShift_;
+        int64_t half = (int64_t)1 << (shift - 1);
+        int64_t sx = ((x * factor + half) >> shift) + centerX_;
+        int64_t sy = ((y * factor + half) >> shift) + centerY_;
+        if (sx < -SCREEN_LIMIT || sx > SCREEN_LIMIT || sy < -SCREEN_LIMIT || sy > SCREEN_LIMIT)
+            return false;
+
+        screen[0] = (int16_t)sx;
+        screen[1] = (int16_t)sy;
+        return true;
+    }
+
+private:
+    // 1/m in Q1.15 for m = 1 + i / 256, i = 0..256
+    static const uint16_t RECIPROCAL[257];
+    // Largest screen coordinate in subpixels, the rasterizer guard band
+    static const int32_t SCREEN_LIMIT;
+
+    int32_t rot_[9] = {0};     // Q1.15
+    int32_t scale_ = 0;        // camera Q16.16 per (Q1.15 rotation * int16 position), >> scaleShift_
+    int scaleShift_ = 0;
+    int32_t translation_[3] = {0, 0, 0}; // Q16.16
+    int32_t focal_ = 0;        // fov * 16 subpixels, >> focalShift_
+    int focalShift_ = 0;
+    int32_t centerX_ = 0;      // subpixels
+    int32_t centerY_ = 0;
+    int32_t nearZ_ = 0;        // Q16.16
+};
@@ -15,6 +15,16 @@ struct lua_State;
 #include "dirtyTiles.hpp"
 #endif
 #include "controller.hpp"
+#include "tilemap.hpp"
+#include "particles.hpp"
+#include "collisionWorld.hpp"
+#include "physicsWorld.hpp"
+#include "boardGrid.hpp"
+#include "depthSort.hpp"
+#include "rasterizer3d.hpp"
+#include "tileDepthRenderer.hpp"
+#include "meshFormat.hpp"
+#include "fixedTransform3d.hpp"
 #if ENABLE_WIFI
 #include <WebSocketsClient.h>
 typedef void (*WiFiInitCallback)();
@@ -75,10 +85,60 @@ private:
     static int lge_create_sprite(lua_State *L);
     static int lge_delay_ms(lua_State *L);
     static int lge_fps(lua_State *L);
+    static int lge_sin(lua_State *L);
+    static int lge_cos(lua_State *L);
+    static int lge_sincos(lua_State *L);
     static int lge_get_mouse_click(lua_State *L);
     static int lge_get_mouse_position(lua_State *L);
     static int lge_is_key_down(lua_State *L);
 
+    // Tilemap functions
+    static int lge_create_tilemap(lua_State *L);
+    static int lge_tilemap_set(lua_State *L);
+    static int lge_tilemap_get(lua_State *L);
+    static int lge_tilemap_fill(lua_State *L);
+    static int lge_tilemap_set_scroll(lua_State *L);
+    static int lge_draw_tilemap(lua_State *L);
+
+    // Particle functions
+    static int lge_create_emitter(lua_State *L);
+    static int lge_emitter_burst(lua_State *L);
+    static int lge_update_emitter(lua_State *L);
+    static int lge_draw_emitter(lua_State *L);
+    static int lge_emitter_count(lua_State *L);
+    static int lge_emitter_clear(lua_State *L);
+
+    // Collision functions
+    static int lge_collision_world(lua_State *L);
+    static int lge_collision_insert(lua_State *L);
+    static int lge_collision_insert_rect(lua_State *L);
+    static int lge_collision_move(lua_State *L);
+    static int lge_collision_remove(lua_State *L);
+    static int lge_collision_query(lua_State *L);
+    static int lge_collision_pairs(lua_State *L);
+
+    // Physics functions
+    static int lge_physics_world(lua_State *L);
+    static int lge_physics_add_circle(lua_State *L);
+    static int lge_physics_add_rect(lua_State *L);
+    static int lge_physics_remove(lua_State *L);
+    static int lge_physics_set_position(lua_State *L);
+    static int lge_physics_set_velocity(lua_State *L);
+    static int lge_physics_get_body(lua_State *L);
+    static int lge_physics_step(lua_State *L);
+    static int lge_physics_get_positions(lua_State *L);
+
+    // Grid functions
+    static int lge_create_grid(lua_State *L);
+    static int lge_grid_get(lua_State *L);
+    static int lge_grid_set(lua_State *L);
+    static int lge_grid_fill(lua_State *L);
+    static int lge_grid_swap(lua_State *L);
+    static int lge_grid_find_runs(lua_State *L);
+    static int lge_grid_collapse_columns(lua_State *L);
+    static int lge_grid_flood_fill(lua_State *L);
+    static int lge_grid_count_neighbors(lua_State *L);
+
 // WebSocket functions
 #if ENABLE_WIFI
     static int lge_ws_connect(lua_State *L);
@@ -89,42 +149,327 @@ private:
     static int lge_ws_loop(lua_State *L);
 #endif
 
+    struct TilemapLayer
+    {
+        Tilemap map;
+        std::vector<uint16_t> tileColors565; // tileset, index 0 = tile value 1
+        uint16_t background565;              // color of empty (0) cells
+        uint32_t canvasGeneration;           // canvas generation the map was last drawn on
+    };
+
+    std::vector<TilemapLayer> tilemaps_;
+    std::vector<TileSpan> tileSpans_; // scratch, reused by every tilemap draw
+
+    // Incremented by every clear_canvas, so retained layers know when to fully redraw
+    uint32_t canvasGeneration_ = 0;
+
+    TilemapLayer *checkTilemap(lua_State *L, int arg);
+
+    std::vector<ParticleEmitter> emitters_;
+
+    ParticleEmitter *checkEmitter(lua_State *L, int arg);
+
+    struct CollisionLayer
+    {
+        CollisionWorld world;
+        int resultRef; // Lua registry reference of the reusable result table
+    };
+
+    std::vector<CollisionLayer> collisionWorlds_;
+    std::vector<int> collisionResults_; // scratch, reused by every query
+
+    CollisionLayer *checkCollisionWorld(lua_State *L, int arg);
+
+    struct PhysicsLayer
+    {
+        PhysicsWorld world;
+        int resultRef; // Lua registry reference of the reusable position table
+    };
+
+    std::vector<PhysicsLayer> physicsWorlds_;
+
+    PhysicsLayer *checkPhysicsWorld(lua_State *L, int arg);
+
+    struct GridLayer
+    {
+        BoardGrid grid;
+        int resultRef; // Lua registry reference of the reusable result table
+    };
+
+    std::vector<GridLayer> grids_;
+    std::vector<int> gridResults_; // scratch, reused by every grid kernel
+
+    GridLayer *checkGrid(lua_State *L, int arg);
+
+    // Results are written into the caller's table at `arg` if given, otherwise into a table kept alive by `ref`
+    static void pushResultTable(lua_State *L, int arg, int &ref);
+
     // 3D functions
     static int lge_set_3d_camera(lua_State *L);
+    static int lge_set_3d_view(lua_State *L);
     static int lge_set_3d_light(lua_State *L); // Avoid using lighting with blue colors due to 3-3-2 color representation limitations
     static int lge_create_3d_model(lua_State *L);
+    static int lge_load_3d_model(lua_State *L);
     static int lge_create_3d_instance(lua_State *L);
     static int lge_draw_3d_instance(lua_State *L);
+    static int lge_draw_3d_instances(lua_State *L);
+    static int lge_set_3d_depth_buffer(lua_State *L);
+    static int lge_set_3d_instance_retained(lua_State *L);
+    static int lge_set_3d_model_fixed_point(lua_State *L);
+    static int lge_set_3d_instance_smooth(lua_State *L);
+    static int lge_create_3d_texture(lua_State *L);
+    static int lge_destroy_3d_instance(lua_State *L);
+    static int lge_destroy_3d_model(lua_State *L);
+
+    // One level of detail of a model. Mesh data points either into the owning Model3D's vectors
+    // or into a mesh blob (see meshFormat.hpp).
+    struct Mesh3D
+    {
+        // flat quantized positions [x1,y1,z1, x2,y2,z2, ...], model space position = value * vertexScale
+        const int16_t *vertices = nullptr;
+        size_t vertCount = 0;
+        float vertexScale = 1.0f;
+        // 0-based vertex indices, triplets per triangle: 8-bit when the mesh has at most 256 vertices, else 16-bit
+        const uint8_t *indices8 = nullptr;
+        const uint16_t *indices16 = nullptr;
+        size_t faceCnt = 0;
+        // unit normal per triangle in Q1.15 [nx,ny,nz, ...], model space
+        const int16_t *faceNormals = nullptr;
+        // plane offset per triangle in the units of faceNormals, n . p + d > 0 for points p in front of the face
+        const float *facePlaneD = nullptr;
+        // bounding sphere, model space
+        float boundCenter[3] = {0.0f, 0.0f, 0.0f};
+        float boundRadius = 0.0f;
+        // per triangle, the triangle of the finest level it was decimated from (instance colors are per finest
+        // triangle); nullptr on the finest level
+        const uint16_t *faceSource = nullptr;
+        // projected radius in pixels below which the next coarser level is drawn, 0 on the coarsest level
+        float lodRadius = 0.0f;
+        // unit normal per vertex in Q1.15 (area-weighted average of its faces), for smooth shading;
+        // nullptr until an instance of the model is made smooth
+        const int16_t *vertexNormals = nullptr;
+
+        size_t vertexCount() const { return vertCount; }
+        size_t faceCount() const { return faceCnt; }
+        uint16_t index(size_t i) const { return indices8 ? indices8[i] : indices16[i]; }
+
+        void position(size_t i, float p[3]) const
+        {
+            p[0] = vertices[i * 3 + 0] * vertexScale;
+            p[1] = vertices[i * 3 + 1] * vertexScale;
+            p[2] = vertices[i * 3 + 2] * vertexScale;
+        }
+    };
 
     struct Model3D
     {
-        // flat [x1,y1,z1, x2,y2,z2, ...]
-        std::vector<float> vertices;
-        // 0-based vertex indices, triplets per triangle
-        std::vector<uint16_t> indices;
+        // Levels of detail, finest first
+        std::vector<Mesh3D> lods;
+
+        // Storage for models built from Lua tables
+        std::vector<int16_t> vertexStore;
+        std::vector<uint8_t> index8Store;
+        std::vector<uint16_t> index16Store;
+        std::vector<int16_t> normalStore;
+        std::vector<float> planeStore;
+        std::vector<int16_t> vertexNormalStore; // every level's vertexNormals, finest first, once an instance is smooth
+        // Registry reference pinning a Lua string blob, or the userdata a SPIFFS file was read into
+        int blobRef = -2; // LUA_NOREF, lauxlib.h is not included here
+        // Transform and project vertices in fixed point (FixedTransform3D) instead of float
+        bool fixedPoint = false;
+        // Live instances of this model, which can't be destroyed before them
+        int instanceCount = 0;
+        // Pool slot state, see handle3d
+        uint16_t generation = 0;
+        bool alive = true;
+
+        // The meshes may point into this model's own vectors
+        Model3D() = default;
+        Model3D(Model3D &&) = default;
+        Model3D &operator=(Model3D &&) = default;
+        Model3D(const Model3D &) = delete;
+        Model3D &operator=(const Model3D &) = delete;
+    };
+
+    // Most levels of detail a model can have
+    static constexpr int MAX_LODS_3D = 8;
+    // Projected radius band around a level's switch radius in which the current level is kept
+    static constexpr float LOD_HYSTERESIS_3D = 0.15f;
+
+    // Fixed-point one of Mesh3D::faceNormals
+    static constexpr float NORMAL_ONE_3D = 32767.0f;
+
+    static void computeFacePlanes(Model3D &model);
+    static void computeBoundingSphere(Mesh3D &mesh);
+    static void computeVertexNormals(Model3D &model);
+
+    // 8-bit texture, canvas (RGB332) texels row-major, power-of-two sides
+    struct Texture3D
+    {
+        std::vector<uint8_t> texels;
+        int widthLog2 = 0;
+        int heightLog2 = 0;
     };
 
+    // Largest texture side, as a power of two
+    static constexpr int MAX_TEXTURE_LOG2_3D = 8;
+    // Textured faces longer than this on screen (pixels) are split in camera space, so the affine
+    // mapping only has to bridge short distances
+    static constexpr float TEXTURE_SUBDIVIDE_3D = 32.0f;
+    // Most times a textured face is halved (4^depth pieces at most)
+    static constexpr int TEXTURE_SUBDIVIDE_DEPTH_3D = 3;
+
     struct Instance3D
     {
-        int modelIndex;                      // index into models3d_
+        int modelIndex = -1;                 // index into models3d_
+        int lodLevel = 0;                    // level of detail drawn last
         std::vector<uint16_t> faceColors565; // one color per triangle
+        std::vector<uint16_t> facePalette;   // per triangle, index of its base color in shadeTable332
+        std::vector<uint8_t> shadeTable332;  // LIGHT_LEVELS_3D canvas colors per unique base color, darkest first
+        bool smooth = false;                 // Gouraud shading from vertex normals through shadeTable332
+        int textureIndex = -1;               // index into textures3d_, -1 if the faces are colored
+        std::vector<float> faceUV;           // textured: per finest triangle, u, v in texels for each corner
+
+        // Pose cache: once the same pose is drawn twice in a row, its transformed vertices and
+        // visible faces are kept and replayed until the pose or the view changes
+        float pose[7] = {0.0f};              // wx, wy, wz, radius, ax, ay, az of the last draw
+        uint32_t poseGeneration = 0;         // view3dGeneration_ of the last draw, 0 = never drawn
+        bool poseCached = false;
+        std::vector<int16_t> cachedScreenXY; // screenXY3d_ and cameraZ3d_ of the instance's vertices
+        std::vector<float> cachedCameraZ;
+        std::vector<uint16_t> cachedShade;   // vertexShade3d_, smooth instances only
+        std::vector<int32_t> cachedUV;       // vertexUV3d_, textured instances only
+        std::vector<int> cachedFaceB;        // visible faces, 3 vertex indices each relative to the instance
+        std::vector<float> cachedFaceZ;
+        std::vector<uint8_t> cachedFaceColor;
+        std::vector<int32_t> cachedFaceRamp; // per visible face, offset of its ramp in shadeTable332 (or
+                                             // textureShade332_ if textured), -1 if none
+
+        // Retained instances skip drawing entirely while their pose is cached and the canvas wasn't cleared
+        bool retained = false;
+        bool retainedVisible = false;        // whether the last real draw put any face on the canvas
+        uint32_t canvasGeneration = 0;       // canvas generation of the last real draw
+
+        // Pool slot state, see handle3d. A destroyed instance's vectors keep their capacity for the next one.
+        uint16_t generation = 0;
+        bool alive = true;
     };
 
+    // Lua ids of pooled models and instances: slot + 1 in the low 16 bits, the slot's generation above,
+    // so the id of a destroyed object stays invalid after its slot is reused. First-use ids are 1, 2, 3...
+    static constexpr int HANDLE_SLOT_BITS_3D = 16;
+    static constexpr uint16_t HANDLE_GENERATION_MASK_3D = 0x7FFF; // ids stay positive
+    static int handle3d(size_t slot, uint16_t generation)
+    {
+        return (int)(((uint32_t)generation << HANDLE_SLOT_BITS_3D) | (uint32_t)(slot + 1));
+    }
+    // Slot of a live object, or -1 for ids that were never issued or were destroyed
+    template <typename T>
+    static int slot3d(const std::vector<T> &pool, int64_t id)
+    {
+        if (id <= 0 || id > 0x7FFFFFFF)
+            return -1;
+        size_t slot = (size_t)(id & ((1 << HANDLE_SLOT_BITS_3D) - 1)) - 1;
+        uint16_t generation = (uint16_t)(id >> HANDLE_SLOT_BITS_3D);
+        if (slot >= pool.size() || !pool[slot].alive || pool[slot].generation != generation)
+            return -1;
+        return (int)slot;
+    }
+
+    // Brightness quantization for lit faces, the 8-bit canvas can't show finer steps anyway
+    static constexpr int LIGHT_LEVELS_3D = 32;
+
+    // Camera-space depth of the near plane, faces crossing it are clipped
+    static constexpr float NEAR_PLANE_3D = 1.0f;
+
+    // Screen x of a transformed vertex behind the near plane or outside the guard band, faces using it are clipped
+    static constexpr int16_t OFFSCREEN_3D = INT16_MIN;
+
+    // Most faces per draw call, the depth sort indexes them with 16 bits. Faces past it are dropped
+    // with a warning, at most once per clear_canvas (see warn3dFaceLimit).
+    static constexpr int MAX_VISIBLE_FACES_3D = 0xFFFF;
+    uint32_t faceLimitWarnedGeneration3d_ = 0;
+    bool faceLimitWarned3d_ = false;
+    bool faceLimitHit3d_ = false; // set by warn3dFaceLimit, keeps the instance's result out of the pose cache
+
     // Camera / projection parameters
     float fov3d_ = 200.0f;
     float camDist3d_ = 100.0f;
 
+    // World to camera transform, row-major 3x4 (rows are the camera right, down and forward axes)
+    float view3d_[12] = {1.0f, 0.0f, 0.0f, 0.0f,
+                         0.0f, 1.0f, 0.0f, 0.0f,
+                         0.0f, 0.0f, 1.0f, 0.0f};
+
+    // Incremented whenever camera or lighting change, so cached instance poses know they are stale
+    uint32_t view3dGeneration_ = 1;
+
     // Registered models & instances
     std::vector<Model3D> models3d_;
     std::vector<Instance3D> instances3d_;
+    std::vector<Texture3D> textures3d_;
+    std::vector<int> freeModels3d_;    // destroyed slots, reused before the pools grow
+    std::vector<int> freeInstances3d_;
+
+    // Lit texels: LIGHT_LEVELS_3D rows of 256 canvas colors, each texel color at that light level.
+    // Built with the first texture.
+    std::vector<uint8_t> textureShade332_;
 
     // Scratch buffers reused every draw (avoid allocations in the hot path)
-    std::vector<float> tempVertices3d_;
+    // Transformed vertices as separate arrays, so each stage only touches what it reads:
+    // screen positions as 12.4 fixed-point x, y pairs (Rasterizer3D subpixels) and camera-space depths
+    std::vector<int16_t> screenXY3d_;
+    std::vector<float> cameraZ3d_;
+    std::vector<uint16_t> vertexShade3d_;    // light level in 8.8 fixed point, smooth instances and clipped vertices
+    std::vector<int32_t> vertexUV3d_;        // texture u, v pairs in 16.16 texels, vertices of textured faces
+    std::vector<int> frontFaces3d_;          // faces surviving model-space culling
+    std::vector<uint32_t> touchedVertices3d_; // bitmap of vertices referenced by front faces
     std::vector<float> visibleZ_;
     std::vector<int> visibleB1_;
     std::vector<int> visibleB2_;
     std::vector<int> visibleB3_;
-    std::vector<uint16_t> visibleColor_;
+    std::vector<uint8_t> visibleColor_; // canvas (RGB332) color
+    std::vector<const uint8_t *> visibleRamp_; // shade ramp of a smooth face or texel remap of a lit textured one
+    std::vector<const Texture3D *> visibleTexture_; // nullptr if the face isn't textured
+    std::vector<uint16_t> visibleSlot_;  // which queued instance a visible face belongs to
+    std::vector<int> batchBounds3d_;     // per queued instance: minX, minY, maxX, maxY
+    DepthSorter depthSorter3d_;
+    Rasterizer3D rasterizer3d_;
+    FixedTransform3D fixedTransform3d_;
+
+    // Optional depth-tested path, replaces the depth sort when enabled
+    bool depthBuffer3d_ = false;
+    TileDepthRenderer tileRenderer3d_;
+    std::vector<uint16_t> touchedTiles3d_;
+
+    void reserve3dModel(lua_State *L);
+    int add3dModel(Model3D &&model);
+    int reserve3dInstance(lua_State *L);
+    static void reset3dInstance(Instance3D &inst);
+    void reserve3dScratch(size_t vertexEnd, size_t faceEnd);
+    void warn3dFaceLimit();
+    bool queue3dInstance(int64_t instanceId, float wx, float wy, float wz, float radius,
+                         float ax, float ay, float az, int slot, size_t &vertexBase, int &visCount);
+    // How a queued face is filled: flat color, shade ramp (smooth) or texture (with an optional texel remap)
+    struct FaceStyle3D
+    {
+        uint8_t color;
+        const uint8_t *ramp;
+        const Texture3D *texture;
+    };
+
+    // Corner attributes of faces built in camera space: x, y, z, 8.8 shade, texture u, v (texels)
+    static constexpr int CORNER_ATTRS_3D = 6;
+
+    void push3dFace(float avgZ, int b1, int b2, int b3, const FaceStyle3D &style, int slot, int &visCount);
+    void clip3dFace(const float corners[3][CORNER_ATTRS_3D], const FaceStyle3D &style, int slot, size_t &vertexEnd,
+                    int &visCount);
+    void subdivide3dFace(const float corners[3][CORNER_ATTRS_3D], const FaceStyle3D &style, int depth, int slot,
+                         size_t &vertexEnd, int &visCount);
+    int transform3dInstance(Instance3D &inst, float wx, float wy, float wz, float radius,
+                            float ax, float ay, float az, int slot, size_t &vertexBase, int &visCount);
+    void draw3dFaces(int visCount, int slotCount);
+    void draw3dFacesDepthTested(int visCount);
 
     // lighting:
     bool lightEnabled_ = false;
@@ -150,6 +495,8 @@ private:
 
     static uint16_t parseHexColor(const char *hex);
     static uint16_t scaleColor565(uint16_t c, float factor);
+    static uint8_t color565To332(uint16_t c);
+    static uint16_t color332To565(uint8_t c);
 
 #if DIRTY_RECTS_OPTIMIZATION
     std::vector<DirtyRect> current_dirty_rects_;
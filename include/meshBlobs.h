@@ -0,0 +1,20 @@
+// Auto-generated by lua/3dmodels/meshToBin.py, meshes embedded in flash for lge.load_3d_model(name)
+#ifndef MESHBLOBS_H
+#define MESHBLOBS_H
+
+#include <cstddef>
+#include <cstdint>
+
+const uint8_t *const mesh_blobs[] = {
+  nullptr
+};
+
+const size_t mesh_blob_sizes[] = {
+  0
+};
+
+const char *const mesh_names[] = {
+  nullptr
+};
+
+#endif // MESHBLOBS_H
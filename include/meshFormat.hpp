@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Binary 3D mesh format (.lgem), little-endian, written by lua/3dmodels/meshToBin.py.
+// The blob is used in place: the engine points straight into it, so it must be 4-byte aligned
+// and stay alive (flash, a loaded file or a pinned Lua string) as long as the model exists.
+//
+//   MeshHeader                               40 bytes
+//   int16  positions[vertexCount * 3]        position = value * vertexScale
+//   uint8  or uint16 indices[faceCount * 3]  0-based, 8-bit when MESH_FLAG_INDEX8 is set
+//   int16  faceNormals[faceCount * 3]        unit normals in Q1.15
+//   float  facePlaneD[faceCount]             n . p + d > 0 in front of the face, in Q1.15 normal units
+//   uint16 faceSource[faceCount]             only with MESH_FLAG_FACE_SOURCE, see below
+//
+// Every section starts on a 4-byte boundary, padding bytes are zero.
+//
+// A blob may chain levels of detail, finest first: nextOffset is the distance from this header to the
+// next level's header (0 on the last level). Coarser levels carry faceSource, the index of the finest
+// level's triangle each of their triangles was decimated from, so per-face colors follow the mesh.
+static constexpr uint32_t MESH_MAGIC = 0x4D45474C; // "LGEM"
+static constexpr uint16_t MESH_VERSION = 2;
+static constexpr uint16_t MESH_FLAG_INDEX8 = 0x0001;
+static constexpr uint16_t MESH_FLAG_FACE_SOURCE = 0x0002;
+
+struct MeshHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t flags;
+    uint16_t vertexCount;
+    uint16_t faceCount;
+    float vertexScale;
+    float boundCenter[3];
+    float boundRadius;
+    float lodRadius;     // projected radius in pixels below which the next level is drawn
+    uint32_t nextOffset; // bytes from this header to the next level's, 0 on the last level
+};
+static_assert(sizeof(MeshHeader) == 40, "MeshHeader must match the file layout");
+
+// Pointers into a validated mesh blob
+struct MeshView
+{
+    const MeshHeader *header = nullptr;
+    const int16_t *vertices = nullptr;
+    const uint8_t *indices8 = nullptr;   // set when MESH_FLAG_INDEX8
+    const uint16_t *indices16 = nullptr; // set otherwise
+    const int16_t *faceNormals = nullptr;
+    const float *facePlaneD = nullptr;
+    const uint16_t *faceSource = nullptr; // set when MESH_FLAG_FACE_SOURCE
+};
+
+// True if `data` starts with the mesh magic
+bool isMeshBlob(const void *data, size_t size);
+
+// Checks one level's header, section sizes, alignment and index ranges, then fills `view`.
+// Returns nullptr on success, or a short description of the problem.
+// Follow header->nextOffset for the next level; faceSource ranges are left to the caller.
+const char *parseMeshBlob(const void *data, size_t size, MeshView &view);
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Fixed-point format used for particle positions and velocities (24.8)
+constexpr int PARTICLE_FP_SHIFT = 8;
+constexpr int32_t PARTICLE_FP_ONE = 1 << PARTICLE_FP_SHIFT;
+
+// Largest emitter pool, 22 bytes per particle
+constexpr int PARTICLE_MAX_CAPACITY = 2048;
+
+struct EmitterParams
+{
+    int capacity = 64;      // Maximum live particles, allocated once (1..PARTICLE_MAX_CAPACITY)
+    float lifeMin = 0.3f;   // Seconds
+    float lifeMax = 0.6f;   // Seconds
+    float speedMin = 30.0f; // Pixels per second
+    float speedMax = 120.0f;
+    float angle = 0.0f;          // Emission direction in radians
+    float spread = 6.2831853f;   // Emission cone width in radians (full circle by default)
+    float gravity = 0.0f;        // Pixels per second^2, positive is down
+    uint8_t size = 2;            // Radius in pixels at birth
+    bool shrink = true;          // Radius shrinks towards 1 pixel over the lifetime
+    uint16_t color565 = 0xFFFF;  // Default particle color
+};
+
+// Fixed-capacity particle pool stored as a structure of arrays.
+// Dead particles are removed by swapping the last live particle into their slot,
+// so the live range is always [0, count()).
+class ParticleEmitter
+{
+public:
+    ParticleEmitter(const EmitterParams &params, uint32_t seed);
+
+    // Spawn up to `count` particles at (x, y). Returns how many were actually spawned.
+    int burst(float x, float y, int count, uint16_t color565);
+
+    // Advance all particles by dt seconds using fixed-point integration
+    void update(float dt);
+
+    void clear() { count_ = 0; }
+
+    int count() const { return count_; }
+    int capacity() const { return params_.capacity; }
+    const EmitterParams &params() const { return params_; }
+
+    // Accessors for the native draw pass
+    int pixelX(int i) const { return x_[i] >> PARTICLE_FP_SHIFT; }
+    int pixelY(int i) const { return y_[i] >> PARTICLE_FP_SHIFT; }
+    uint16_t color(int i) const { return color_[i]; }
+    int radius(int i) const;
+
+private:
+    EmitterParams params_;
+    int count_;
+    uint32_t rng_;
+    int32_t ageRemainderUs_; // Part of the elapsed time below a millisecond, carried to the next update
+
+    // Structure of arrays, sized to capacity at construction
+    std::vector<int32_t> x_;
+    std::vector<int32_t> y_;
+    std::vector<int32_t> vx_;
+    std::vector<int32_t> vy_;
+    std::vector<uint16_t> ageMs_;
+    std::vector<uint16_t> lifeMs_;
+    std::vector<uint16_t> color_;
+
+    // xorshift32, returns [0, 1)
+    float nextRandom();
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+enum BodyShape : uint8_t
+{
+    BODY_CIRCLE,
+    BODY_AABB
+};
+
+struct PhysicsParams
+{
+    int capacity = 64;              // Maximum bodies, allocated once
+    float width = 320.0f;           // Wall bounds [0, width] x [0, height]
+    float height = 240.0f;
+    bool walls = true;              // Bounce off the bounds
+    float gravityX = 0.0f;          // Pixels per second^2
+    float gravityY = 0.0f;
+    float fixedDt = 1.0f / 60.0f;   // Integrator timestep in seconds
+    int maxSubsteps = 4;            // Time beyond this many steps per call is dropped
+};
+
+// Fixed-capacity 2D rigid bodies (circles and axis-aligned boxes, no rotation).
+// Semi-implicit Euler on a fixed timestep, sweep-and-prune on X for contacts,
+// impulse resolution with restitution plus positional correction.
+// Positions are body centers for both shapes.
+class PhysicsWorld
+{
+public:
+    explicit PhysicsWorld(const PhysicsParams &params);
+
+    // Returns a 0-based body id, or -1 when the world is full. mass <= 0 makes the body static.
+    int addCircle(float x, float y, float r, float vx, float vy, float mass, float restitution);
+    int addRect(float x, float y, float w, float h, float vx, float vy, float mass, float restitution);
+    bool remove(int id);
+    bool isValid(int id) const;
+
+    bool setPosition(int id, float x, float y);
+    bool setVelocity(int id, float vx, float vy);
+
+    // Advance by dt seconds in fixed steps. Returns the number of steps taken.
+    int step(float dt);
+
+    // Highest used slot + 1, the length of the position readback
+    int slotCount() const { return slotCount_; }
+    float x(int id) const { return x_[id]; }
+    float y(int id) const { return y_[id]; }
+    float vx(int id) const { return vx_[id]; }
+    float vy(int id) const { return vy_[id]; }
+
+private:
+    PhysicsParams params_;
+    float accumulator_;
+    int slotCount_;
+
+    // Structure of arrays, sized to capacity at construction
+    std::vector<float> x_, y_;
+    std::vector<float> vx_, vy_;
+    std::vector<float> halfW_, halfH_; // Circles: radius in both
+    std::vector<float> invMass_;
+    std::vector<float> restitution_;
+    std::vector<uint8_t> shape_;
+    std::vector<uint8_t> active_;
+    std::vector<int> freeIds_;
+
+    // Active bodies sorted by min X, kept between steps so insertion sort runs on nearly sorted data
+    std::vector<int> order_;
+
+    int allocate(float x, float y, float hw, float hh, float vx, float vy, float mass, float restitution, BodyShape shape);
+    void substep(float dt);
+    void sortAxis();
+    void collideWalls(int i);
+    void resolve(int a, int b);
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+
+// Flat-shaded, Gouraud-shaded and affine-textured triangle fill for the 3D path, writing spans straight into
+// the 8-bit (RGB332) canvas.
+// Vertices are snapped to 28.4 fixed point and edges are walked exactly in integers. A pixel is filled when
+// its center lies inside the triangle, centers exactly on a top or left edge count as inside
+// (top-left rule), so triangles sharing an edge neither overlap nor leave gaps.
+class Rasterizer3D
+{
+public:
+    // Vertices must stay within +-GUARD_BAND pixels, so that 28.4 positions also fit 16 bits (12.4)
+    static constexpr float GUARD_BAND = 2047.0f;
+
+    void setTarget(uint8_t *buffer, int width, int height);
+
+    // Returns false without drawing if there is no target or a vertex lies outside the guard band
+    bool fillTriangle(float x0, float y0, float x1, float y1, float x2, float y2, uint8_t color);
+
+    // Same with vertices already in 28.4 fixed point (see toSubpixel), which must lie within the guard band
+    bool fillTriangleSubpixel(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint8_t color);
+
+    // Gouraud variant: s0..s2 are per-vertex shades in 8.8 fixed point, interpolated across the triangle.
+    // Each pixel is ramp[shade >> 8]; the ramp must cover every index up to max(s0, s1, s2) >> 8.
+    bool fillTriangleShaded(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                            uint16_t s0, uint16_t s1, uint16_t s2, const uint8_t *ramp);
+
+    // Affine texture mapping: uv holds u0, v0, u1, v1, u2, v2 in 16.16 texels, interpolated linearly in screen
+    // space and wrapped to the texture. The texture is 8-bit with power-of-two sides, texels row-major.
+    // With a remap table (256 entries) each texel is drawn as remap[texel], e.g. to light it.
+    bool fillTriangleTextured(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2,
+                              const int32_t uv[6], const uint8_t *texels, int widthLog2, int heightLog2,
+                              const uint8_t *remap);
+
+    // Largest texture coordinate magnitude in texels, so that 16.16 values keep clear of int32 overflow
+    static constexpr float TEXTURE_UV_LIMIT = 8192.0f;
+
+    // Pixel coordinates to 28.4 fixed point, rounded to the nearest 1/16 pixel (floor without a libm call)
+    static inline int32_t toSubpixel(float v)
+    {
+        float f = v * 16.0f + 0.5f;
+        int32_t i = (int32_t)f;
+        return (f < (float)i) ? i - 1 : i;
+    }
+
+    static inline bool inGuardBand(float x, float y)
+    {
+        // Written so that NaN fails the test too
+        return x > -GUARD_BAND && x < GUARD_BAND && y > -GUARD_BAND && y < GUARD_BAND;
+    }
+
+    static inline bool inGuardBand(float x0, float y0, float x1, float y1, float x2, float y2)
+    {
+        return inGuardBand(x0, y0) && inGuardBand(x1, y1) && inGuardBand(x2, y2);
+    }
+
+private:
+    uint8_t *buffer_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+
+    // Shade as a plane over pixel centers, 8.8 units, clamped to the vertex range
+    struct ShadePlane
+    {
+        float s0;   // at the center of pixel (0, 0)
+        float dsdx;
+        float dsdy;
+        float lo;
+        float hi;
+        const uint8_t *ramp;
+    };
+    const ShadePlane *shade_ = nullptr; // set while a shaded triangle is filled
+
+    // Texture coordinates as planes over pixel centers, in texels
+    struct TexturePlane
+    {
+        float u0, dudx, dudy; // at the center of pixel (0, 0)
+        float v0, dvdx, dvdy;
+        const uint8_t *texels;
+        int widthLog2;
+        uint32_t uMask; // width - 1
+        uint32_t vMask; // height - 1
+        const uint8_t *remap;
+    };
+    const TexturePlane *texture_ = nullptr; // set while a textured triangle is filled
+
+    // Exact integer edge walk (DDA): x is the first column at or right of the edge on the current row
+    struct Edge
+    {
+        int32_t x;
+        int32_t step;    // whole columns per row
+        int32_t err;     // remainder, in [0, denom)
+        int32_t errStep;
+        int32_t denom;
+
+        inline void advance()
+        {
+            x += step;
+            err += errStep;
+            if (err >= denom)
+            {
+                ++x;
+                err -= denom;
+            }
+        }
+    };
+
+    static Edge setupEdge(int32_t xa, int32_t ya, int32_t xb, int32_t yb, int row, bool wide);
+    void fillRows(int yStart, int yEnd, Edge &left, Edge &right, uint8_t color);
+    void fillSpanShaded(uint8_t *row, int y, int x1, int x2) const;
+    void fillSpanTextured(uint8_t *row, int y, int x1, int x2) const;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "dirtyTiles.hpp"
+
+// Depth-tested 3D triangle rendering without a full-screen Z-buffer.
+// Triangles are binned into TILE_SIZE screen tiles (the same grid DirtyTileManager uses) and
+// each tile is rasterized against an 8-bit depth buffer on the stack. Depth is 1/z, interpolated
+// linearly in screen space and quantized over the range of the triangles touching the tile, so
+// intersecting and overlapping faces resolve per pixel and no depth sort is needed.
+// Coverage follows the same top-left rule on 28.4 vertices as Rasterizer3D.
+class TileDepthRenderer
+{
+public:
+    // Forget queued triangles, size the tile grid for the target
+    void begin(int width, int height);
+
+    // Queue a triangle with screen positions and camera-space depths (z > 0).
+    // Returns false (not queued) if a vertex lies outside Rasterizer3D::GUARD_BAND.
+    bool addTriangle(float x0, float y0, float z0,
+                     float x1, float y1, float z1,
+                     float x2, float y2, float z2, uint8_t color);
+
+    // Same with screen positions already in 28.4 fixed point, which must lie within the guard band.
+    // With a ramp, pixels are Gouraud shaded instead: s0..s2 are 8.8 shades and each pixel is
+    // ramp[shade >> 8], as in Rasterizer3D::fillTriangleShaded.
+    void addTriangleSubpixel(int32_t x0, int32_t y0, float z0,
+                             int32_t x1, int32_t y1, float z1,
+                             int32_t x2, int32_t y2, float z2, uint8_t color,
+                             const uint8_t *ramp = nullptr, uint16_t s0 = 0, uint16_t s1 = 0, uint16_t s2 = 0);
+
+    // Affine-textured triangle, arguments as in Rasterizer3D::fillTriangleTextured
+    void addTriangleTextured(int32_t x0, int32_t y0, float z0,
+                             int32_t x1, int32_t y1, float z1,
+                             int32_t x2, int32_t y2, float z2,
+                             const int32_t uv[6], const uint8_t *texels, int widthLog2, int heightLog2,
+                             const uint8_t *remap);
+
+    // Rasterize all queued triangles into the 8-bit canvas. Appends the index (ty * tilesX + tx)
+    // of every tile that received pixels to touchedTiles.
+    void render(uint8_t *buffer, std::vector<uint16_t> &touchedTiles);
+
+    int tilesX() const { return tilesX_; }
+
+private:
+    // Vertex attributes carried into the attribute planes
+    enum { ATTR_SHADE, ATTR_U, ATTR_V, ATTR_COUNT };
+
+    struct Triangle
+    {
+        int64_t edgeC[3];     // Edge functions at pixel (0, 0), top-left bias applied, inside when all >= 0
+        int32_t edgeA[3];     // Change per pixel step in x
+        int32_t edgeB[3];     // Change per pixel step in y
+        float w0, dwdx, dwdy; // 1/z plane at pixel center (0, 0)
+        float wMin, wMax;
+        const uint8_t *ramp;   // Gouraud shade ramp, or the texel remap of a textured triangle
+        const uint8_t *texels; // Textured when set
+        float a0[ATTR_COUNT], dadx[ATTR_COUNT], dady[ATTR_COUNT]; // Attribute planes at pixel center (0, 0): 8.8 shade, texture u, v
+        float sMin, sMax;
+        int16_t minX, minY, maxX, maxY; // Pixel bounds, clipped to the target
+        uint8_t color;
+        uint8_t widthLog2, heightLog2;  // Texture size
+    };
+
+    int width_ = 0;
+    int height_ = 0;
+    int tilesX_ = 0;
+    int tilesY_ = 0;
+
+    std::vector<Triangle> triangles_;
+    std::vector<int> binStart_;      // Per tile offset into binned_, tilesX_ * tilesY_ + 1 entries
+    std::vector<uint16_t> binned_;   // Triangle indices grouped by tile
+
+    bool setupTriangle(int32_t X[3], int32_t Y[3], float z[3], float A[3][ATTR_COUNT], Triangle &t);
+    void buildBins();
+    void renderTile(uint8_t *buffer, int tx, int ty, bool &touched);
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Axis-aligned pixel rectangle covered by a run of tilemap cells on screen
+struct TileSpan
+{
+    int x, y, w, h;
+    uint8_t tile; // Cell value (0 = empty / background)
+};
+
+class Tilemap
+{
+public:
+    Tilemap(int cols, int rows, int tileW, int tileH);
+
+    int cols() const { return cols_; }
+    int rows() const { return rows_; }
+    int tileWidth() const { return tileW_; }
+    int tileHeight() const { return tileH_; }
+
+    // Cell access (0-based). Out-of-range reads return 0, writes are ignored.
+    uint8_t get(int col, int row) const;
+    void set(int col, int row, uint8_t value);
+    void fill(uint8_t value);
+
+    // Pixel scroll offset of the map inside its viewport
+    void setScroll(int scrollX, int scrollY);
+    int scrollX() const { return scrollX_; }
+    int scrollY() const { return scrollY_; }
+
+    // Force every cell to be redrawn on the next collectSpans()
+    void markAllDirty();
+
+    // Collect the on-screen rectangles that need redrawing for a viewport placed at (vx, vy, vw, vh).
+    // Horizontally adjacent dirty cells with the same value are merged into one span.
+    // A changed viewport redraws everything. Clears the dirty state.
+    void collectSpans(int vx, int vy, int vw, int vh, std::vector<TileSpan> &spans);
+
+private:
+    int cols_;
+    int rows_;
+    int tileW_;
+    int tileH_;
+    int scrollX_;
+    int scrollY_;
+
+    // Compact cell storage, one byte per cell
+    std::vector<uint8_t> cells_;
+    // Cells changed since the last collectSpans()
+    std::vector<bool> dirty_;
+    bool allDirty_;
+
+    // Viewport used by the last collectSpans(), to detect moves/resizes
+    int lastVx_, lastVy_, lastVw_, lastVh_;
+
+    inline int getCellIndex(int col, int row) const
+    {
+        return row * cols_ + col;
+    }
+};
@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+# Converts meshes to the binary .lgem format loaded by lge.load_3d_model (layout in include/meshFormat.hpp).
+#
+#   meshToBin.py input.(obj|gltf|glb|stl...) output.lgem        binary file, upload it to SPIFFS (data/)
+#   meshToBin.py -m header input1.obj [input2.obj ...]          embeds the meshes in include/meshBlobs.h
+#
+# Options, before the other arguments:
+#   --lod N         adds up to N coarser levels of detail, each with about half the triangles of the previous
+#   --lod-error PX  largest on-screen error in pixels a coarser level may introduce (default 1.0)
+#
+# Meshes are recentered and normalized to radius 1, like objModelToLua.py and meshToLua.py.
+# .obj files are read directly, other formats need trimesh (see requirements.txt).
+import sys
+import math
+import struct
+from pathlib import Path
+
+MESH_MAGIC = b"LGEM"
+MESH_VERSION = 2
+MESH_FLAG_INDEX8 = 0x0001
+MESH_FLAG_FACE_SOURCE = 0x0002
+NORMAL_ONE = 32767
+MAX_LODS = 8
+
+
+def f32(x):
+    # Round through a 32-bit float, as the engine stores it
+    return struct.unpack("<f", struct.pack("<f", x))[0]
+
+
+def load_obj(path):
+    vertices = []
+    faces = []
+    with path.open("r", encoding="utf-8") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("v "):
+                _, x, y, z, *rest = line.split()
+                vertices.append((float(x), float(y), float(z)))
+            elif line.startswith("f "):
+                idxs = [int(p.split("/")[0]) for p in line.split()[1:] if p.split("/")[0]]
+                # triangulate via fan, 0-based
+                for k in range(1, len(idxs) - 1):
+                    faces.append((idxs[0] - 1, idxs[k] - 1, idxs[k + 1] - 1))
+    return vertices, faces
+
+
+def load_mesh(path):
+    if path.suffix.lower() == ".obj":
+        return load_obj(path)
+
+    import trimesh
+
+    mesh = trimesh.load_mesh(path, force="mesh")
+    if isinstance(mesh, trimesh.Scene):
+        mesh = trimesh.util.concatenate([g for g in mesh.geometry.values()])
+    return [tuple(v) for v in mesh.vertices.tolist()], [tuple(f) for f in mesh.faces.tolist()]
+
+
+def normalize(vertices):
+    cx = (min(v[0] for v in vertices) + max(v[0] for v in vertices)) * 0.5
+    cy = (min(v[1] for v in vertices) + max(v[1] for v in vertices)) * 0.5
+    cz = (min(v[2] for v in vertices) + max(v[2] for v in vertices)) * 0.5
+    centered = [(x - cx, y - cy, z - cz) for x, y, z in vertices]
+    max_r = max(math.sqrt(x * x + y * y + z * z) for x, y, z in centered) or 1.0
+    return [(x / max_r, y / max_r, z / max_r) for x, y, z in centered]
+
+
+def decimate(vertices, faces, target_faces):
+    # Vertex clustering: snap vertices to a grid, merge each cell into its average and drop the faces
+    # that collapse. The grid coarsens until at most target_faces remain.
+    # Returns (vertices, faces, source face per face, largest vertex displacement), or None.
+    lo = [min(v[k] for v in vertices) for k in range(3)]
+    extent = max(max(v[k] for v in vertices) - lo[k] for k in range(3)) or 1.0
+    cells = 128
+    while cells >= 1:
+        size = extent / cells
+        cluster_of = {}
+        members = []
+        remap = []
+        for v in vertices:
+            key = tuple(int((v[k] - lo[k]) / size) for k in range(3))
+            if key not in cluster_of:
+                cluster_of[key] = len(members)
+                members.append([])
+            members[cluster_of[key]].append(v)
+            remap.append(cluster_of[key])
+
+        new_faces = []
+        source = []
+        seen = set()
+        for f, (i1, i2, i3) in enumerate(faces):
+            a, b, c = remap[i1], remap[i2], remap[i3]
+            if a == b or b == c or a == c:
+                continue
+            key = min((a, b, c), (b, c, a), (c, a, b))
+            if key in seen:
+                continue
+            seen.add(key)
+            new_faces.append((a, b, c))
+            source.append(f)
+
+        if len(new_faces) <= target_faces:
+            if not new_faces:
+                return None
+            # Keep only referenced clusters
+            used = sorted({i for f in new_faces for i in f})
+            index_of = {c: n for n, c in enumerate(used)}
+            new_vertices = [tuple(sum(p[k] for p in members[c]) / len(members[c]) for k in range(3)) for c in used]
+            new_faces = [tuple(index_of[i] for i in f) for f in new_faces]
+            return new_vertices, new_faces, source, size * math.sqrt(3.0)
+        cells = int(cells * 0.8)
+    return None
+
+
+def build_lods(vertices, faces, lod_count, lod_error):
+    # Finest first: (vertices, faces, source, switch radius in pixels)
+    levels = [(vertices, faces, None, 0.0)]
+    while len(levels) <= min(lod_count, MAX_LODS - 1):
+        coarser = decimate(vertices, faces, len(levels[-1][1]) // 2)
+        if coarser is None:
+            break
+        new_vertices, new_faces, source, error = coarser
+        # The sphere has radius 1, so `error` projects to error * radius pixels:
+        # draw the coarser level once that stays within lod_error
+        prev = levels[-1]
+        levels[-1] = (prev[0], prev[1], prev[2], lod_error / error)
+        levels.append((new_vertices, new_faces, source, 0.0))
+    return levels
+
+
+def build_blob(vertices, faces, face_source=None, lod_radius=0.0):
+    if len(vertices) > 0xFFFF or len(faces) > 0xFFFF:
+        raise ValueError("mesh too large: %d vertices, %d faces (max 65535 each)" % (len(vertices), len(faces)))
+
+    # Quantize positions, the largest coordinate maps to +-32767
+    max_abs = max(abs(c) for v in vertices for c in v) or 1.0
+    scale = f32(max_abs / 32767.0)
+    qverts = [tuple(int(round(c / scale)) for c in v) for v in vertices]
+    positions = [tuple(c * scale for c in q) for q in qverts]
+
+    # Face planes from the quantized positions, normals in Q1.15
+    normals = []
+    planes = []
+    for i1, i2, i3 in faces:
+        p1, p2, p3 = positions[i1], positions[i2], positions[i3]
+        e1 = [p2[k] - p1[k] for k in range(3)]
+        e2 = [p3[k] - p1[k] for k in range(3)]
+        n = (e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0])
+        length = math.sqrt(sum(c * c for c in n))
+        if length > 1e-6:
+            qn = tuple(int(round(c / length * NORMAL_ONE)) for c in n)
+            planes.append(-sum(qn[k] * p1[k] for k in range(3)))
+        else:
+            qn = (0, 0, 0)
+            planes.append(0.0)
+        normals.append(qn)
+
+    # Bounding sphere around the bounding box center
+    center = [(min(p[k] for p in positions) + max(p[k] for p in positions)) * 0.5 for k in range(3)]
+    radius = max(math.sqrt(sum((p[k] - center[k]) ** 2 for k in range(3))) for p in positions)
+
+    index8 = len(vertices) <= 256
+    flags = MESH_FLAG_INDEX8 if index8 else 0
+    if face_source is not None:
+        flags |= MESH_FLAG_FACE_SOURCE
+
+    def pad4(data):
+        return data + b"\0" * (-len(data) % 4)
+
+    # nextOffset is patched by convert() when levels are chained
+    blob = struct.pack("<4sHHHHf3fffI", MESH_MAGIC, MESH_VERSION, flags, len(vertices), len(faces),
+                       scale, center[0], center[1], center[2], radius, lod_radius, 0)
+    blob += pad4(b"".join(struct.pack("<3h", *q) for q in qverts))
+    blob += pad4(b"".join(struct.pack("<3B" if index8 else "<3H", *f) for f in faces))
+    blob += pad4(b"".join(struct.pack("<3h", *n) for n in normals))
+    blob += b"".join(struct.pack("<f", d) for d in planes)
+    if face_source is not None:
+        blob += pad4(b"".join(struct.pack("<H", f) for f in face_source))
+    return blob
+
+
+def convert(path, lod_count=0, lod_error=1.0):
+    vertices, faces = load_mesh(path)
+    if not vertices or not faces:
+        raise ValueError("no vertices or faces in %s" % path)
+
+    blob = b""
+    levels = build_lods(normalize(vertices), faces, lod_count, lod_error)
+    for n, (level_vertices, level_faces, source, lod_radius) in enumerate(levels):
+        level = build_blob(level_vertices, level_faces, source, lod_radius)
+        if n + 1 < len(levels):
+            level = level[:36] + struct.pack("<I", len(level)) + level[40:]
+        blob += level
+    if len(levels) > 1:
+        print("%s: %s triangles" % (path.name, " -> ".join(str(len(level[1])) for level in levels)))
+    return blob
+
+
+def write_header(paths, out_path, lod_count=0, lod_error=1.0):
+    names = [Path(p).stem for p in paths]
+    symbols = ["mesh_blob_" + "".join(c if c.isalnum() else "_" for c in name) for name in names]
+
+    with out_path.open("w", encoding="utf-8") as out:
+        out.write("// Auto-generated by lua/3dmodels/meshToBin.py, meshes embedded in flash for lge.load_3d_model(name)\n")
+        out.write("#ifndef MESHBLOBS_H\n#define MESHBLOBS_H\n\n#include <cstddef>\n#include <cstdint>\n\n")
+        for path, symbol in zip(paths, symbols):
+            blob = convert(Path(path), lod_count, lod_error)
+            out.write("// %s\n" % Path(path).name)
+            out.write("alignas(4) const uint8_t %s[] = {\n" % symbol)
+            for i in range(0, len(blob), 16):
+                out.write("  " + ", ".join("0x%02x" % b for b in blob[i:i + 16]) + ",\n")
+            out.write("};\n\n")
+
+        out.write("const uint8_t *const mesh_blobs[] = {\n")
+        for symbol in symbols:
+            out.write("  %s,\n" % symbol)
+        out.write("  nullptr\n};\n\n")
+
+        out.write("const size_t mesh_blob_sizes[] = {\n")
+        for symbol in symbols:
+            out.write("  sizeof(%s),\n" % symbol)
+        out.write("  0\n};\n\n")
+
+        out.write("const char *const mesh_names[] = {\n")
+        for name in names:
+            out.write("  \"%s\",\n" % name)
+        out.write("  nullptr\n};\n\n#endif // MESHBLOBS_H\n")
+
+
+if __name__ == "__main__":
+    args = sys.argv[1:]
+    lod_count = 0
+    lod_error = 1.0
+    while len(args) >= 2 and args[0] in ("--lod", "--lod-error"):
+        if args[0] == "--lod":
+            lod_count = int(args[1])
+        else:
+            lod_error = float(args[1])
+        args = args[2:]
+
+    if len(args) >= 3 and args[0] == "-m" and args[1] == "header":
+        out_path = Path(__file__).resolve().parent.parent.parent / "include" / "meshBlobs.h"
+        write_header(args[2:], out_path, lod_count, lod_error)
+        print("Wrote", out_path)
+    elif len(args) == 2:
+        blob = convert(Path(args[0]), lod_count, lod_error)
+        Path(args[1]).write_bytes(blob)
+        print("Wrote %d bytes to %s" % (len(blob), args[1]))
+    else:
+        print(f"Usage: {sys.argv[0]} [--lod N] [--lod-error PX] input_mesh.(obj|gltf|glb|stl...) output.lgem")
+        print(f"       {sys.argv[0]} [--lod N] [--lod-error PX] -m header input1.obj [input2.obj ...]   (writes include/meshBlobs.h)")
+        sys.exit(1)
@@ -0,0 +1,189 @@
+#include "boardGrid.hpp"
+#include <algorithm>
+
+static const int NEIGHBOR_DX[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+static const int NEIGHBOR_DY[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+BoardGrid::BoardGrid(int cols, int rows)
+    : cols_(std::max(1, cols)), rows_(std::max(1, rows))
+{
+    cells_.resize(cols_ * rows_, 0);
+}
+
+uint8_t BoardGrid::get(int col, int row) const
+{
+    if (!inBounds(col, row))
+        return 0;
+
+    return cells_[getCellIndex(col, row)];
+}
+
+void BoardGrid::set(int col, int row, uint8_t value)
+{
+    if (!inBounds(col, row))
+        return;
+
+    cells_[getCellIndex(col, row)] = value;
+}
+
+void BoardGrid::fill(uint8_t value)
+{
+    std::fill(cells_.begin(), cells_.end(), value);
+}
+
+bool BoardGrid::swap(int col1, int row1, int col2, int row2)
+{
+    if (!inBounds(col1, row1) || !inBounds(col2, row2))
+        return false;
+
+    std::swap(cells_[getCellIndex(col1, row1)], cells_[getCellIndex(col2, row2)]);
+    return true;
+}
+
+int BoardGrid::findRuns(int minLen, std::vector<int> &out) const
+{
+    if (minLen < 1)
+        minLen = 1;
+
+    int runs = 0;
+
+    // Horizontal runs
+    for (int row = 0; row < rows_; ++row)
+    {
+        const uint8_t *line = &cells_[getCellIndex(0, row)];
+        int start = 0;
+        while (start < cols_)
+        {
+            uint8_t value = line[start];
+            int end = start + 1;
+            while (end < cols_ && line[end] == value)
+                ++end;
+
+            if (value != 0 && end - start >= minLen)
+            {
+                out.push_back(start);
+                out.push_back(row);
+                out.push_back(end - start);
+                out.push_back(0);
+                ++runs;
+            }
+            start = end;
+        }
+    }
+
+    // Vertical runs
+    for (int col = 0; col < cols_; ++col)
+    {
+        int start = 0;
+        while (start < rows_)
+        {
+            uint8_t value = cells_[getCellIndex(col, start)];
+            int end = start + 1;
+            while (end < rows_ && cells_[getCellIndex(col, end)] == value)
+                ++end;
+
+            if (value != 0 && end - start >= minLen)
+            {
+                out.push_back(col);
+                out.push_back(start);
+                out.push_back(end - start);
+                out.push_back(1);
+                ++runs;
+            }
+            start = end;
+        }
+    }
+
+    return runs;
+}
+
+int BoardGrid::collapseColumns(std::vector<int> &out)
+{
+    int moved = 0;
+
+    for (int col = 0; col < cols_; ++col)
+    {
+        int writeRow = rows_ - 1;
+        for (int row = rows_ - 1; row >= 0; --row)
+        {
+            int idx = getCellIndex(col, row);
+            uint8_t value = cells_[idx];
+            if (value == 0)
+                continue;
+
+            if (row != writeRow)
+            {
+                cells_[getCellIndex(col, writeRow)] = value;
+                cells_[idx] = 0;
+
+                out.push_back(col);
+                out.push_back(row);
+                out.push_back(writeRow);
+                ++moved;
+            }
+            --writeRow;
+        }
+    }
+
+    return moved;
+}
+
+int BoardGrid::floodFill(int col, int row, uint8_t newValue, bool diagonal)
+{
+    if (!inBounds(col, row))
+        return 0;
+
+    uint8_t target = cells_[getCellIndex(col, row)];
+    if (target == newValue)
+        return 0;
+
+    int directions = diagonal ? 8 : 4;
+    int filled = 0;
+
+    stack_.clear();
+    stack_.push_back(getCellIndex(col, row));
+    cells_[stack_.back()] = newValue;
+
+    while (!stack_.empty())
+    {
+        int idx = stack_.back();
+        stack_.pop_back();
+        ++filled;
+
+        int c = idx % cols_;
+        int r = idx / cols_;
+        for (int d = 0; d < directions; ++d)
+        {
+            int nc = c + NEIGHBOR_DX[d];
+            int nr = r + NEIGHBOR_DY[d];
+            if (!inBounds(nc, nr))
+                continue;
+
+            int nidx = getCellIndex(nc, nr);
+            if (cells_[nidx] == target)
+            {
+                // Recolor on push so no cell is queued twice
+                cells_[nidx] = newValue;
+                stack_.push_back(nidx);
+            }
+        }
+    }
+
+    return filled;
+}
+
+int BoardGrid::countNeighbors(int col, int row, uint8_t value, bool diagonal) const
+{
+    int directions = diagonal ? 8 : 4;
+    int count = 0;
+
+    for (int d = 0; d < directions; ++d)
+    {
+        int nc = col + NEIGHBOR_DX[d];
+        int nr = row + NEIGHBOR_DY[d];
+        if (inBounds(nc, nr) && cells_[getCellIndex(nc, nr)] == value)
+            ++count;
+    }
+
+    return count;
+}
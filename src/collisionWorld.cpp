@@ -0,0 +1,305 @@
+#include "collisionWorld.hpp"
+#include <algorithm>
+
+CollisionWorld::CollisionWorld(float cellSize)
+    : cellSize_(cellSize > 1.0f ? cellSize : 1.0f), dirty_(true), stamp_(0)
+{
+    invCellSize_ = 1.0f / cellSize_;
+    bucketStart_.resize(BUCKET_COUNT + 1, 0);
+}
+
+int CollisionWorld::allocate(const Collider &c)
+{
+    dirty_ = true;
+    if (!freeIds_.empty())
+    {
+        int id = freeIds_.back();
+        freeIds_.pop_back();
+        colliders_[id] = c;
+        return id;
+    }
+
+    colliders_.push_back(c);
+    queryStamp_.push_back(0);
+    return (int)colliders_.size() - 1;
+}
+
+int CollisionWorld::insertCircle(float x, float y, float r, uint16_t category, uint16_t mask)
+{
+    Collider c = {x, y, r, r, category, mask, COLLIDER_CIRCLE, true};
+    return allocate(c);
+}
+
+int CollisionWorld::insertRect(float x, float y, float w, float h, uint16_t category, uint16_t mask)
+{
+    Collider c = {x, y, w, h, category, mask, COLLIDER_AABB, true};
+    return allocate(c);
+}
+
+bool CollisionWorld::isValid(int id) const
+{
+    return id >= 0 && id < (int)colliders_.size() && colliders_[id].active;
+}
+
+bool CollisionWorld::move(int id, float x, float y, float w, float h)
+{
+    if (!isValid(id))
+        return false;
+
+    Collider &c = colliders_[id];
+    c.x = x;
+    c.y = y;
+    if (w >= 0.0f)
+        c.w = w;
+    if (h >= 0.0f)
+        c.h = h;
+    else if (c.shape == COLLIDER_CIRCLE)
+        c.h = c.w;
+
+    dirty_ = true;
+    return true;
+}
+
+bool CollisionWorld::remove(int id)
+{
+    if (!isValid(id))
+        return false;
+
+    colliders_[id].active = false;
+    freeIds_.push_back(id);
+    dirty_ = true;
+    return true;
+}
+
+void CollisionWorld::bounds(const Collider &c, float &x1, float &y1, float &x2, float &y2)
+{
+    if (c.shape == COLLIDER_CIRCLE)
+    {
+        x1 = c.x - c.w;
+        y1 = c.y - c.w;
+        x2 = c.x + c.w;
+        y2 = c.y + c.w;
+    }
+    else
+    {
+        x1 = c.x;
+        y1 = c.y;
+        x2 = c.x + c.w;
+        y2 = c.y + c.h;
+    }
+}
+
+bool CollisionWorld::overlaps(const Collider &a, const Collider &b)
+{
+    if (a.shape == COLLIDER_CIRCLE && b.shape == COLLIDER_CIRCLE)
+    {
+        float dx = a.x - b.x;
+        float dy = a.y - b.y;
+        float rr = a.w + b.w;
+        return dx * dx + dy * dy < rr * rr;
+    }
+
+    if (a.shape == COLLIDER_AABB && b.shape == COLLIDER_AABB)
+    {
+        return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+    }
+
+    // Circle vs AABB: distance from the center to the closest point of the box
+    const Collider &circle = (a.shape == COLLIDER_CIRCLE) ? a : b;
+    const Collider &box = (a.shape == COLLIDER_CIRCLE) ? b : a;
+    float cx = std::max(box.x, std::min(circle.x, box.x + box.w));
+    float cy = std::max(box.y, std::min(circle.y, box.y + box.h));
+    float dx = circle.x - cx;
+    float dy = circle.y - cy;
+    return dx * dx + dy * dy < circle.w * circle.w;
+}
+
+bool CollisionWorld::cellRange(float x1, float y1, float x2, float y2, int &cx1, int &cy1, int &cx2,
+                               int &cy2) const
+{
+    // Range check before converting, a float beyond int range is undefined to cast
+    const float limit = 32767.0f * cellSize_;
+    if (!(x1 > -limit && y1 > -limit && x2 < limit && y2 < limit))
+        return false;
+
+    cx1 = cellCoord(x1);
+    cy1 = cellCoord(y1);
+    cx2 = cellCoord(x2);
+    cy2 = cellCoord(y2);
+    return cx2 - cx1 < MAX_CELL_SPAN && cy2 - cy1 < MAX_CELL_SPAN;
+}
+
+void CollisionWorld::rebuild()
+{
+    unsorted_.clear();
+    large_.clear();
+
+    // 1. One entry per (collider, cell) it touches
+    for (int i = 0; i < (int)colliders_.size(); ++i)
+    {
+        const Collider &c = colliders_[i];
+        if (!c.active)
+            continue;
+
+        float x1, y1, x2, y2;
+        bounds(c, x1, y1, x2, y2);
+        int cx1, cy1, cx2, cy2;
+        if (!cellRange(x1, y1, x2, y2, cx1, cy1, cx2, cy2))
+        {
+            large_.push_back(i);
+            continue;
+        }
+
+        for (int cy = cy1; cy <= cy2; ++cy)
+        {
+            for (int cx = cx1; cx <= cx2; ++cx)
+            {
+                unsorted_.push_back({i, (int16_t)cx, (int16_t)cy});
+            }
+        }
+    }
+
+    // 2. Counting sort by bucket
+    std::fill(bucketStart_.begin(), bucketStart_.end(), 0);
+    for (const CellEntry &e : unsorted_)
+    {
+        bucketStart_[bucketOf(e.cellX, e.cellY) + 1]++;
+    }
+    for (int b = 0; b < BUCKET_COUNT; ++b)
+    {
+        bucketStart_[b + 1] += bucketStart_[b];
+    }
+
+    entries_.resize(unsorted_.size());
+    for (const CellEntry &e : unsorted_)
+    {
+        // bucketStart_[b] is used as the write cursor, then restored below
+        entries_[bucketStart_[bucketOf(e.cellX, e.cellY)]++] = e;
+    }
+    for (int b = BUCKET_COUNT; b > 0; --b)
+    {
+        bucketStart_[b] = bucketStart_[b - 1];
+    }
+    bucketStart_[0] = 0;
+
+    dirty_ = false;
+}
+
+void CollisionWorld::queryRect(float x, float y, float w, float h, std::vector<int> &out)
+{
+    out.clear();
+    if (w < 0.0f || h < 0.0f)
+        return;
+
+    if (dirty_)
+        rebuild();
+
+    Collider query = {x, y, w, h, 0xFFFF, 0xFFFF, COLLIDER_AABB, true};
+
+    int cx1, cy1, cx2, cy2;
+    if (!cellRange(x, y, x + w, y + h, cx1, cy1, cx2, cy2))
+    {
+        // Too many cells to visit, a linear scan is cheaper
+        for (int i = 0; i < (int)colliders_.size(); ++i)
+        {
+            if (colliders_[i].active && overlaps(query, colliders_[i]))
+                out.push_back(i);
+        }
+        return;
+    }
+
+    for (int i : large_)
+    {
+        if (overlaps(query, colliders_[i]))
+            out.push_back(i);
+    }
+
+    ++stamp_;
+    for (int cy = cy1; cy <= cy2; ++cy)
+    {
+        for (int cx = cx1; cx <= cx2; ++cx)
+        {
+            int b = bucketOf(cx, cy);
+            for (int e = bucketStart_[b]; e < bucketStart_[b + 1]; ++e)
+            {
+                const CellEntry &entry = entries_[e];
+                if (entry.cellX != cx || entry.cellY != cy || queryStamp_[entry.collider] == stamp_)
+                    continue;
+
+                queryStamp_[entry.collider] = stamp_;
+                if (overlaps(query, colliders_[entry.collider]))
+                    out.push_back(entry.collider);
+            }
+        }
+    }
+}
+
+void CollisionWorld::collectPairs(std::vector<int> &out)
+{
+    out.clear();
+
+    if (dirty_)
+        rebuild();
+
+    for (int b = 0; b < BUCKET_COUNT; ++b)
+    {
+        int start = bucketStart_[b];
+        int end = bucketStart_[b + 1];
+
+        for (int i = start; i < end; ++i)
+        {
+            const CellEntry &ei = entries_[i];
+            const Collider &a = colliders_[ei.collider];
+
+            for (int j = i + 1; j < end; ++j)
+            {
+                const CellEntry &ej = entries_[j];
+                if (ej.collider == ei.collider || ej.cellX != ei.cellX || ej.cellY != ei.cellY)
+                    continue; // Same collider, or a different cell hashed into this bucket
+
+                const Collider &c = colliders_[ej.collider];
+                if (!(a.category & c.mask) || !(c.category & a.mask))
+                    continue;
+
+                float ax1, ay1, ax2, ay2, bx1, by1, bx2, by2;
+                bounds(a, ax1, ay1, ax2, ay2);
+                bounds(c, bx1, by1, bx2, by2);
+                if (ax1 > bx2 || bx1 > ax2 || ay1 > by2 || by1 > ay2)
+                    continue;
+
+                // Report the pair only from the cell holding the top-left corner of the overlap,
+                // so colliders sharing several cells are reported once
+                if (cellCoord(std::max(ax1, bx1)) != ei.cellX || cellCoord(std::max(ay1, by1)) != ei.cellY)
+                    continue;
+
+                if (!overlaps(a, c))
+                    continue;
+
+                int lo = std::min(ei.collider, ej.collider);
+                int hi = std::max(ei.collider, ej.collider);
+                out.push_back(lo);
+                out.push_back(hi);
+            }
+        }
+    }
+
+    // Colliders kept out of the grid against every other one. A pair of two of them
+    // is reported from the lower id only.
+    for (int l : large_)
+    {
+        const Collider &a = colliders_[l];
+        for (int i = 0; i < (int)colliders_.size(); ++i)
+        {
+            const Collider &c = colliders_[i];
+            if (i == l || !c.active || !(a.category & c.mask) || !(c.category & a.mask))
+                continue;
+            if (i < l && std::binary_search(large_.begin(), large_.end(), i))
+                continue;
+            if (!overlaps(a, c))
+                continue;
+
+            out.push_back(std::min(l, i));
+            out.push_back(std::max(l, i));
+        }
+    }
+}
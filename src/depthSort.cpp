@@ -0,0 +1,88 @@
+#include "depthSort.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Below this many faces the 256-entry histograms cost more than an insertion sort
+static constexpr int RADIX_MIN_COUNT = 32;
+
+// Sorts src into dst by one byte of the keys (LSD radix pass)
+static void radixPass(const uint16_t *keys, const uint16_t *src, uint16_t *dst, int count, int shift)
+{
+    int offsets[256];
+    std::memset(offsets, 0, sizeof(offsets));
+
+    for (int i = 0; i < count; ++i)
+        offsets[(keys[src[i]] >> shift) & 0xFF]++;
+
+    int sum = 0;
+    for (int b = 0; b < 256; ++b)
+    {
+        int n = offsets[b];
+        offsets[b] = sum;
+        sum += n;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        uint16_t idx = src[i];
+        dst[offsets[(keys[idx] >> shift) & 0xFF]++] = idx;
+    }
+}
+
+const uint16_t *DepthSorter::sortDescending(const float *depth, int count)
+{
+    if ((int)order_.size() < count)
+    {
+        keys_.resize(count);
+        order_.resize(count);
+        scratch_.resize(count);
+    }
+
+    if (count <= 0)
+        return order_.data();
+
+    float minZ = depth[0];
+    float maxZ = depth[0];
+    for (int i = 1; i < count; ++i)
+    {
+        if (depth[i] < minZ)
+            minZ = depth[i];
+        if (depth[i] > maxZ)
+            maxZ = depth[i];
+    }
+
+    // Key 0 is the farthest face, so an ascending sort yields back-to-front order
+    float range = maxZ - minZ;
+    float scale = (range > 0.0f) ? 65535.0f / range : 0.0f;
+    for (int i = 0; i < count; ++i)
+    {
+        keys_[i] = (uint16_t)((maxZ - depth[i]) * scale);
+        scratch_[i] = (uint16_t)i;
+    }
+
+    if (count < RADIX_MIN_COUNT)
+    {
+        // Insertion sort on the index array, stable like the radix path
+        uint16_t *order = scratch_.data();
+        for (int i = 1; i < count; ++i)
+        {
+            uint16_t idx = order[i];
+            uint16_t key = keys_[idx];
+            int j = i - 1;
+            while (j >= 0 && keys_[order[j]] > key)
+            {
+                order[j + 1] = order[j];
+                --j;
+            }
+            order[j + 1] = idx;
+        }
+        std::swap(order_, scratch_);
+        return order_.data();
+    }
+
+    radixPass(keys_.data(), scratch_.data(), order_.data(), count, 0);
+    radixPass(keys_.data(), order_.data(), scratch_.data(), count, 8);
+
+    std::swap(order_, scratch_);
+    return order_.data();
+}
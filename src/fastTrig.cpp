@@ -0,0 +1,37 @@
+#include "fastTrig.hpp"
+
+// Const, so it stays in flash on the ESP32
+const float SINE_QUARTER_TABLE[257] = {
+    0.0f, 0.0061358846f, 0.012271538f, 0.01840673f, 0.024541229f, 0.0306748032f, 0.036807223f, 0.04293826f,
+    0.0490676743f, 0.0551952443f, 0.061320736f, 0.06744392f, 0.073564564f, 0.07968244f, 0.08579731f, 0.091908956f,
+    0.09801714f, 0.10412163f, 0.110222207f, 0.11631863f, 0.12241068f, 0.1284981f, 0.1345807f, 0.14065824f,
+    0.14673047f, 0.15279719f, 0.158858143f, 0.16491312f, 0.17096189f, 0.17700422f, 0.18303989f, 0.18906866f,
+    0.19509032f, 0.201104635f, 0.20711138f, 0.21311032f, 0.21910124f, 0.22508391f, 0.2310581f, 0.2370236f,
+    0.24298018f, 0.24892761f, 0.25486566f, 0.2607941f, 0.26671276f, 0.27262136f, 0.2785197f, 0.28440754f,
+    0.290284677f, 0.2961509f, 0.30200595f, 0.30784964f, 0.31368174f, 0.31950203f, 0.3253103f, 0.3311063f,
+    0.33688985f, 0.34266072f, 0.34841868f, 0.35416353f, 0.35989504f, 0.365612998f, 0.3713172f, 0.37700741f,
+    0.38268343f, 0.388345047f, 0.39399204f, 0.3996242f, 0.4052413f, 0.41084317f, 0.41642956f, 0.42200027f,
+    0.42755509f, 0.43309382f, 0.43861624f, 0.44412214f, 0.44961133f, 0.45508359f, 0.46053871f, 0.4659765f,
+    0.47139674f, 0.47679923f, 0.48218377f, 0.48755016f, 0.4928982f, 0.49822767f, 0.50353838f, 0.50883014f,
+    0.51410274f, 0.519356f, 0.52458968f, 0.52980362f, 0.53499762f, 0.54017147f, 0.545325f, 0.55045797f,
+    0.55557023f, 0.56066158f, 0.5657318f, 0.57078075f, 0.57580819f, 0.58081396f, 0.58579786f, 0.5907597f,
+    0.5956993f, 0.60061648f, 0.60551104f, 0.6103828f, 0.6152316f, 0.6200572f, 0.6248595f, 0.62963824f,
+    0.6343933f, 0.63912444f, 0.64383154f, 0.6485144f, 0.65317284f, 0.6578067f, 0.6624158f, 0.66699992f,
+    0.671559f, 0.6760927f, 0.680601f, 0.6850837f, 0.68954054f, 0.69397146f, 0.69837625f, 0.70275474f,
+    0.70710678f, 0.7114322f, 0.71573083f, 0.72000251f, 0.7242471f, 0.72846439f, 0.7326543f, 0.7368166f,
+    0.7409511f, 0.74505779f, 0.7491364f, 0.7531868f, 0.7572088f, 0.7612024f, 0.765167266f, 0.76910334f,
+    0.77301045f, 0.7768885f, 0.7807372f, 0.784556597f, 0.7883464f, 0.79210658f, 0.7958369f, 0.79953727f,
+    0.8032075f, 0.8068476f, 0.810457198f, 0.8140363f, 0.8175848f, 0.8211025f, 0.8245893f, 0.82804505f,
+    0.8314696f, 0.8348629f, 0.8382247f, 0.841555f, 0.8448536f, 0.84812034f, 0.8513552f, 0.854558f,
+    0.8577286f, 0.86086694f, 0.86397286f, 0.86704625f, 0.87008699f, 0.873095f, 0.8760701f, 0.8790122f,
+    0.8819213f, 0.8847971f, 0.88763962f, 0.89044872f, 0.8932243f, 0.89596625f, 0.8986745f, 0.9013488f,
+    0.9039893f, 0.9065957f, 0.909168f, 0.91170603f, 0.9142098f, 0.9166791f, 0.9191139f, 0.92151404f,
+    0.9238795f, 0.9262102f, 0.9285061f, 0.93076696f, 0.9329928f, 0.9351835f, 0.937339f, 0.9394592f,
+    0.94154407f, 0.94359346f, 0.9456073f, 0.9475856f, 0.94952818f, 0.951435f, 0.953306f, 0.9551412f,
+    0.95694034f, 0.95870347f, 0.9604305f, 0.9621214f, 0.96377607f, 0.96539444f, 0.96697647f, 0.9685221f,
+    0.97003125f, 0.9715039f, 0.97293995f, 0.97433938f, 0.9757021f, 0.97702814f, 0.9783174f, 0.9795698f,
+    0.98078528f, 0.9819639f, 0.9831055f, 0.9842101f, 0.98527764f, 0.9863081f, 0.9873014f, 0.9882576f,
+    0.9891765f, 0.9900582f, 0.99090264f, 0.99170975f, 0.992479535f, 0.9932119f, 0.993907f, 0.9945646f,
+    0.9951847f, 0.9957674f, 0.9963126f, 0.9968203f, 0.99729046f, 0.99772307f, 0.9981181f, 0.99847558f,
+    0.99879546f, 0.99907773f, 0.99932238f, 0.9995294f, 0.9996988f, 0.9998306f, 0.9999247f, 0.99998118f,
+    1.0f};
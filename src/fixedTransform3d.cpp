@@ -0,0 +1,62 @@
+#include "fixedTransform3d.hpp"
+#include "rasterizer3d.hpp"
+#include <cmath>
+
+// round(32768 / (1 + i / 256))
+const uint16_t FixedTransform3D::RECIPROCAL[257] = {
+    32768, 32640, 32514, 32388, 32264, 32140, 32018, 31896, 31775, 31655, 31536, 31418, 31301, 31184, 31069, 30954,
+    30840, 30728, 30615, 30504, 30394, 30284, 30175, 30067, 29959, 29853, 29747, 29642, 29537, 29434, 29331, 29229,
+    29127, 29026, 28926, 28827, 28728, 28630, 28533, 28436, 28340, 28244, 28150, 28056, 27962, 27869, 27777, 27685,
+    27594, 27504, 27414, 27324, 27236, 27148, 27060, 26973, 26887, 26801, 26715, 26631, 26546, 26462, 26379, 26297,
+    26214, 26133, 26052, 25971, 25891, 25811, 25732, 25653, 25575, 25497, 25420, 25343, 25267, 25191, 25116, 25041,
+    24966, 24892, 24818, 24745, 24672, 24600, 24528, 24457, 24385, 24315, 24245, 24175, 24105, 24036, 23967, 23899,
+    23831, 23764, 23697, 23630, 23564, 23498, 23432, 23367, 23302, 23237, 23173, 23109, 23046, 22982, 22920, 22857,
+    22795, 22733, 22672, 22611, 22550, 22490, 22429, 22370, 22310, 22251, 22192, 22134, 22075, 22017, 21960, 21902,
+    21845, 21789, 21732, 21676, 21620, 21565, 21509, 21454, 21400, 21345, 21291, 21237, 21183, 21130, 21077, 21024,
+    20972, 20919, 20867, 20815, 20764, 20713, 20662, 20611, 20560, 20510, 20460, 20410, 20361, 20311, 20262, 20214,
+    20165, 20117, 20068, 20021, 19973, 19925, 19878, 19831, 19784, 19738, 19692, 19645, 19600, 19554, 19508, 19463,
+    19418, 19373, 19329, 19284, 19240, 19196, 19152, 19108, 19065, 19022, 18979, 18936, 18893, 18851, 18809, 18766,
+    18725, 18683, 18641, 18600, 18559, 18518, 18477, 18437, 18396, 18356, 18316, 18276, 18236, 18197, 18157, 18118,
+    18079, 18040, 18001, 17963, 17924, 17886, 17848, 17810, 17772, 17735, 17697, 17660, 17623, 17586, 17549, 17513,
+    17476, 17440, 17404, 17368, 17332, 17296, 17261, 17225, 17190, 17155, 17120, 17085, 17050, 17015, 16981, 16947,
+    16913, 16878, 16845, 16811, 16777, 16744, 16710, 16677, 16644, 16611, 16578, 16546, 16513, 16481, 16448, 16416,
+    16384};
+
+const int32_t FixedTransform3D::SCREEN_LIMIT = (int32_t)(Rasterizer3D::GUARD_BAND * 16.0f);
+
+bool FixedTransform3D::setup(const float rotation[12], float scale, float extent, float fov, float centerX,
+                             float centerY, float nearZ)
+{
+    // Camera coordinates must fit Q16.16, the reciprocal needs z >= 1.0
+    if (!(extent < 32767.0f) || !(nearZ >= 1.0f) || !(fov > 0.0f) || !std::isfinite(scale) || scale == 0.0f)
+        return false;
+
+    for (int r = 0; r < 3; ++r)
+    {
+        for (int c = 0; c < 3; ++c)
+            rot_[r * 3 + c] = (int32_t)std::lround(rotation[r * 4 + c] * 32768.0f);
+        translation_[r] = (int32_t)std::lround(rotation[r * 4 + 3] * 65536.0f);
+    }
+
+    // Q16.16 camera = (Q1.15 sum) * 2 * scale: keep the multiplier under 2^30 with as many fraction bits as fit
+    int exponent;
+    std::frexp(2.0f * std::fabs(scale), &exponent);
+    scaleShift_ = 30 - exponent;
+    if (scaleShift_ < 0)
+        return false;
+    if (scaleShift_ > 62)
+        scaleShift_ = 62;
+    scale_ = (int32_t)std::lround(std::ldexp(2.0f * scale, scaleShift_));
+
+    // fov * 16 under 2^16, so the per-vertex factor (times a Q1.15 reciprocal) stays under 2^31
+    std::frexp(fov * 16.0f, &exponent);
+    focalShift_ = 16 - exponent;
+    if (focalShift_ < 0)
+        return false;
+    focal_ = (int32_t)std::lround(std::ldexp(fov * 16.0f, focalShift_));
+
+    centerX_ = (int32_t)std::lround(centerX * 16.0f);
+    centerY_ = (int32_t)std::lround(centerY * 16.0f);
+    nearZ_ = (int32_t)std::lround(nearZ * 65536.0f);
+    return true;
+}
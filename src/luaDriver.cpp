@@ -22,10 +22,12 @@ extern "C"
 #include <algorithm>
 
 #include "luaScript.h"
+#include "meshBlobs.h"
 #include <memory>
 #include <SPIFFS.h>
 #include "flags.h"
 #include "luaDriver.hpp"
+#include "fastTrig.hpp"
 
 // C-style Lua hooks (need C linkage compatible signatures)
 static int luaLedControl(lua_State *L);
@@ -369,6 +371,19 @@ void LuaDriver::registerLgeModule()
     lua_pushcclosure(L_, lge_fps, 1);
     lua_setfield(L_, -2, "fps");
 
+    // sin(angle), cos(angle), sincos(angle) -> s, c - table-based, cheaper than math.sin / math.cos
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_sin, 1);
+    lua_setfield(L_, -2, "sin");
+
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_cos, 1);
+    lua_setfield(L_, -2, "cos");
+
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_sincos, 1);
+    lua_setfield(L_, -2, "sincos");
+
     // touch management
     lua_pushlightuserdata(L_, self);
     lua_pushcclosure(L_, lge_get_mouse_click, 1);
@@ -382,6 +397,201 @@ void LuaDriver::registerLgeModule()
     lua_pushcclosure(L_, lge_is_key_down, 1);
     lua_setfield(L_, -2, "is_key_down");
 
+    // --- Tilemap API ---
+
+    // create_tilemap(cols, rows, tile_w, tile_h, tileset, background)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_create_tilemap, 1);
+    lua_setfield(L_, -2, "create_tilemap");
+
+    // tilemap_set(tilemap_id, col, row, tile)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_tilemap_set, 1);
+    lua_setfield(L_, -2, "tilemap_set");
+
+    // tilemap_get(tilemap_id, col, row)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_tilemap_get, 1);
+    lua_setfield(L_, -2, "tilemap_get");
+
+    // tilemap_fill(tilemap_id, tile)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_tilemap_fill, 1);
+    lua_setfield(L_, -2, "tilemap_fill");
+
+    // tilemap_set_scroll(tilemap_id, scroll_x, scroll_y)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_tilemap_set_scroll, 1);
+    lua_setfield(L_, -2, "tilemap_set_scroll");
+
+    // draw_tilemap(tilemap_id, x, y, w, h)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_draw_tilemap, 1);
+    lua_setfield(L_, -2, "draw_tilemap");
+
+    // --- Particle API ---
+
+    // create_emitter(params)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_create_emitter, 1);
+    lua_setfield(L_, -2, "create_emitter");
+
+    // emitter_burst(emitter_id, x, y, count, color)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_emitter_burst, 1);
+    lua_setfield(L_, -2, "emitter_burst");
+
+    // update_emitter(emitter_id, dt)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_update_emitter, 1);
+    lua_setfield(L_, -2, "update_emitter");
+
+    // draw_emitter(emitter_id)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_draw_emitter, 1);
+    lua_setfield(L_, -2, "draw_emitter");
+
+    // emitter_count(emitter_id)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_emitter_count, 1);
+    lua_setfield(L_, -2, "emitter_count");
+
+    // emitter_clear(emitter_id)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_emitter_clear, 1);
+    lua_setfield(L_, -2, "emitter_clear");
+
+    // --- Collision API ---
+
+    // collision_world(cell_size)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_collision_world, 1);
+    lua_setfield(L_, -2, "collision_world");
+
+    // collision_insert(world_id, x, y, r, category, mask)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_collision_insert, 1);
+    lua_setfield(L_, -2, "collision_insert");
+
+    // collision_insert_rect(world_id, x, y, w, h, category, mask)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_collision_insert_rect, 1);
+    lua_setfield(L_, -2, "collision_insert_rect");
+
+    // collision_move(world_id, body_id, x, y, w, h)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_collision_move, 1);
+    lua_setfield(L_, -2, "collision_move");
+
+    // collision_remove(world_id, body_id)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_collision_remove, 1);
+    lua_setfield(L_, -2, "collision_remove");
+
+    // collision_query(world_id, x, y, w, h, out)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_collision_query, 1);
+    lua_setfield(L_, -2, "collision_query");
+
+    // collision_pairs(world_id, out)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_collision_pairs, 1);
+    lua_setfield(L_, -2, "collision_pairs");
+
+    // --- Physics API ---
+
+    // physics_world(params)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_world, 1);
+    lua_setfield(L_, -2, "physics_world");
+
+    // physics_add_circle(world_id, x, y, r, vx, vy, mass, restitution)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_add_circle, 1);
+    lua_setfield(L_, -2, "physics_add_circle");
+
+    // physics_add_rect(world_id, x, y, w, h, vx, vy, mass, restitution)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_add_rect, 1);
+    lua_setfield(L_, -2, "physics_add_rect");
+
+    // physics_remove(world_id, body_id)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_remove, 1);
+    lua_setfield(L_, -2, "physics_remove");
+
+    // physics_set_position(world_id, body_id, x, y)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_set_position, 1);
+    lua_setfield(L_, -2, "physics_set_position");
+
+    // physics_set_velocity(world_id, body_id, vx, vy)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_set_velocity, 1);
+    lua_setfield(L_, -2, "physics_set_velocity");
+
+    // physics_get_body(world_id, body_id)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_get_body, 1);
+    lua_setfield(L_, -2, "physics_get_body");
+
+    // physics_step(world_id, dt)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_step, 1);
+    lua_setfield(L_, -2, "physics_step");
+
+    // physics_get_positions(world_id, out)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_physics_get_positions, 1);
+    lua_setfield(L_, -2, "physics_get_positions");
+
+    // --- Grid API ---
+
+    // create_grid(cols, rows)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_create_grid, 1);
+    lua_setfield(L_, -2, "create_grid");
+
+    // grid_get(grid_id, col, row)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_grid_get, 1);
+    lua_setfield(L_, -2, "grid_get");
+
+    // grid_set(grid_id, col, row, value)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_grid_set, 1);
+    lua_setfield(L_, -2, "grid_set");
+
+    // grid_fill(grid_id, value)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_grid_fill, 1);
+    lua_setfield(L_, -2, "grid_fill");
+
+    // grid_swap(grid_id, col1, row1, col2, row2)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_grid_swap, 1);
+    lua_setfield(L_, -2, "grid_swap");
+
+    // grid_find_runs(grid_id, min_len, out)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_grid_find_runs, 1);
+    lua_setfield(L_, -2, "grid_find_runs");
+
+    // grid_collapse_columns(grid_id, out)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_grid_collapse_columns, 1);
+    lua_setfield(L_, -2, "grid_collapse_columns");
+
+    // grid_flood_fill(grid_id, col, row, value, diagonal)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_grid_flood_fill, 1);
+    lua_setfield(L_, -2, "grid_flood_fill");
+
+    // grid_count_neighbors(grid_id, col, row, value, diagonal)
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_grid_count_neighbors, 1);
+    lua_setfield(L_, -2, "grid_count_neighbors");
+
     // --- 3D API ---
 
     // set_3d_camera(fov, cam_distance)
@@ -389,21 +599,71 @@ void LuaDriver::registerLgeModule()
     lua_pushcclosure(L_, lge_set_3d_camera, 1);
     lua_setfield(L_, -2, "set_3d_camera");
 
+    // set_3d_view(eye_x, eye_y, eye_z, target_x, target_y, target_z[, up_x, up_y, up_z])
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_set_3d_view, 1);
+    lua_setfield(L_, -2, "set_3d_view");
+
     // create_3d_model(vertices_flat, faces_flat)
     lua_pushlightuserdata(L_, self);
     lua_pushcclosure(L_, lge_create_3d_model, 1);
     lua_setfield(L_, -2, "create_3d_model");
 
-    // create_3d_instance(model_id, tri_colors)
+    // load_3d_model(path_or_blob) - binary mesh from an embedded array, a SPIFFS file or a string
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_load_3d_model, 1);
+    lua_setfield(L_, -2, "load_3d_model");
+
+    // create_3d_texture(width, height, pixels, [palette]) -> texture_id
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_create_3d_texture, 1);
+    lua_setfield(L_, -2, "create_3d_texture");
+
+    // create_3d_instance(model_id, tri_colors, [texture_id, tri_uvs])
     lua_pushlightuserdata(L_, self);
     lua_pushcclosure(L_, lge_create_3d_instance, 1);
     lua_setfield(L_, -2, "create_3d_instance");
 
-    // draw_3d_instance(instance_id, wx, wy, wz, radius, ax, ay, az)
+    // destroy_3d_instance(instance_id) -> ok - frees the slot for the next instance, the id becomes invalid
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_destroy_3d_instance, 1);
+    lua_setfield(L_, -2, "destroy_3d_instance");
+
+    // destroy_3d_model(model_id) -> ok - only once no instance uses it
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_destroy_3d_model, 1);
+    lua_setfield(L_, -2, "destroy_3d_model");
+
+    // draw_3d_instance(instance_id, wx, wy, wz, radius, ax, ay, az) -> visible
     lua_pushlightuserdata(L_, self);
     lua_pushcclosure(L_, lge_draw_3d_instance, 1);
     lua_setfield(L_, -2, "draw_3d_instance");
 
+    // set_3d_instance_retained(instance_id, enabled) - skip redrawing while the pose is unchanged and the canvas wasn't cleared
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_set_3d_instance_retained, 1);
+    lua_setfield(L_, -2, "set_3d_instance_retained");
+
+    // set_3d_instance_smooth(instance_id, enabled) - Gouraud shading from vertex normals
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_set_3d_instance_smooth, 1);
+    lua_setfield(L_, -2, "set_3d_instance_smooth");
+
+    // set_3d_model_fixed_point(model_id, enabled) - transform and project the model's vertices with integer math
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_set_3d_model_fixed_point, 1);
+    lua_setfield(L_, -2, "set_3d_model_fixed_point");
+
+    // set_3d_depth_buffer(enabled) - per-pixel depth test in screen tiles instead of sorting faces
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_set_3d_depth_buffer, 1);
+    lua_setfield(L_, -2, "set_3d_depth_buffer");
+
+    // draw_3d_instances(params_flat[, count]) -> visible_count - 8 numbers per instance as in draw_3d_instance, one shared depth sort
+    lua_pushlightuserdata(L_, self);
+    lua_pushcclosure(L_, lge_draw_3d_instances, 1);
+    lua_setfield(L_, -2, "draw_3d_instances");
+
     // set_3d_light(dx, dy, dz, ambient, diffuse)
     lua_pushlightuserdata(L_, self);
     lua_pushcclosure(L_, lge_set_3d_light, 1);
@@ -537,6 +797,15 @@ static inline int hexVal(char c)
                         : 0;
 }
 
+// Read an optional numeric field from the table at `idx`
+static float optFieldNumber(lua_State *L, int idx, const char *name, float def)
+{
+    lua_getfield(L, idx, name);
+    float value = lua_isnumber(L, -1) ? (float)lua_tonumber(L, -1) : def;
+    lua_pop(L, 1);
+    return value;
+}
+
 uint16_t LuaDriver::parseHexColor(const char *hex)
 {
     if (!hex || hex[0] != '#' || strlen(hex) < 7)
@@ -549,6 +818,24 @@ uint16_t LuaDriver::parseHexColor(const char *hex)
     return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
 }
 
+// Same packing TFT_eSprite uses when drawing a 565 color into an 8-bit canvas
+uint8_t LuaDriver::color565To332(uint16_t c)
+{
+    return ((c & 0xE000) >> 8) | ((c & 0x0700) >> 6) | ((c & 0x0018) >> 3);
+}
+
+// Inverse of color565To332, each channel's bits repeated to fill the wider field
+uint16_t LuaDriver::color332To565(uint8_t c)
+{
+    uint16_t r3 = (c >> 5) & 0x07;
+    uint16_t g3 = (c >> 2) & 0x07;
+    uint16_t b2 = c & 0x03;
+    uint16_t r5 = (r3 << 2) | (r3 >> 1);
+    uint16_t g6 = (g3 << 3) | g3;
+    uint16_t b5 = (b2 << 3) | (b2 << 1) | (b2 >> 1);
+    return (r5 << 11) | (g6 << 5) | b5;
+}
+
 uint16_t LuaDriver::scaleColor565(uint16_t c, float factor)
 {
     if (factor < 0.0f)
@@ -584,6 +871,7 @@ int LuaDriver::lge_clear_canvas(lua_State *L)
 
         uint16_t color = self->parseHexColor(hex);
         self->spr_->fillScreen(color);
+        self->canvasGeneration_++;
 
         // When clearing the whole screen, the whole screen is dirty!
         // This makes the next lge_present perform a full copy.
@@ -627,6 +915,27 @@ int LuaDriver::lge_delay_ms(lua_State *L)
     return 0;
 }
 
+int LuaDriver::lge_sin(lua_State *L)
+{
+    lua_pushnumber(L, fastSin((float)luaL_checknumber(L, 1)));
+    return 1;
+}
+
+int LuaDriver::lge_cos(lua_State *L)
+{
+    lua_pushnumber(L, fastCos((float)luaL_checknumber(L, 1)));
+    return 1;
+}
+
+int LuaDriver::lge_sincos(lua_State *L)
+{
+    float s, c;
+    fastSinCos((float)luaL_checknumber(L, 1), s, c);
+    lua_pushnumber(L, s);
+    lua_pushnumber(L, c);
+    return 2;
+}
+
 int LuaDriver::lge_fps(lua_State *L)
 {
     LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
@@ -946,405 +1255,2549 @@ int LuaDriver::lge_is_key_down(lua_State *L)
     }
 }
 
-int LuaDriver::lge_set_3d_camera(lua_State *L)
+LuaDriver::TilemapLayer *LuaDriver::checkTilemap(lua_State *L, int arg)
 {
-    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
-    if (!self)
-        return 0;
-
-    self->fov3d_ = (float)luaL_checknumber(L, 1);
-    self->camDist3d_ = (float)luaL_checknumber(L, 2);
-
-    return 0;
+    int tilemapId = (int)luaL_checkinteger(L, arg);
+    if (tilemapId <= 0 || tilemapId > (int)tilemaps_.size())
+    {
+        luaL_error(L, "lge: invalid tilemap id %d", tilemapId);
+        return nullptr;
+    }
+    return &tilemaps_[tilemapId - 1];
 }
 
-int LuaDriver::lge_create_3d_model(lua_State *L)
+// Lua binding: lge.create_tilemap(cols, rows, tile_w, tile_h, tileset, background)
+int LuaDriver::lge_create_tilemap(lua_State *L)
 {
     LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
     if (!self)
         return 0;
 
-    luaL_checktype(L, 1, LUA_TTABLE); // vertices_flat
-    luaL_checktype(L, 2, LUA_TTABLE); // faces_flat
-
-    Model3D model;
-
-    // --- Read vertices ---
-    size_t vlen = lua_rawlen(L, 1);
-    if (vlen % 3 != 0)
-    {
-        Serial.printf("lge.create_3d_model: vertex array length %u is not multiple of 3\n", (unsigned)vlen);
-    }
+    int cols = (int)luaL_checkinteger(L, 1);
+    int rows = (int)luaL_checkinteger(L, 2);
+    int tileW = (int)luaL_checkinteger(L, 3);
+    int tileH = (int)luaL_checkinteger(L, 4);
+    luaL_checktype(L, 5, LUA_TTABLE); // tileset colors, tile value 1..n
+    const char *bgHex = luaL_optstring(L, 6, "#000000");
 
-    model.vertices.resize(vlen);
-    for (size_t i = 0; i < vlen; ++i)
+    if (cols <= 0 || rows <= 0 || tileW <= 0 || tileH <= 0)
     {
-        lua_rawgeti(L, 1, (int)(i + 1));
-        model.vertices[i] = (float)luaL_checknumber(L, -1);
-        lua_pop(L, 1);
+        return luaL_error(L, "lge.create_tilemap: invalid size %dx%d cells of %dx%d px", cols, rows, tileW, tileH);
     }
 
-    // --- Read faces (indices) ---
-    size_t flen = lua_rawlen(L, 2);
-    if (flen % 3 != 0)
+    size_t tlen = lua_rawlen(L, 5);
+    if (tlen > 255)
     {
-        Serial.printf("lge.create_3d_model: face index array length %u is not multiple of 3\n", (unsigned)flen);
+        Serial.printf("lge.create_tilemap: tileset has %u entries, only the first 255 are used\n", (unsigned)tlen);
+        tlen = 255;
     }
 
-    model.indices.resize(flen);
-    for (size_t i = 0; i < flen; ++i)
+    TilemapLayer layer = {Tilemap(cols, rows, tileW, tileH), {}, parseHexColor(bgHex), 0};
+    layer.tileColors565.resize(tlen);
+    for (size_t i = 0; i < tlen; ++i)
     {
-        lua_rawgeti(L, 2, (int)(i + 1));
-        int idx1based = (int)luaL_checkinteger(L, -1);
+        lua_rawgeti(L, 5, (int)(i + 1));
+        const char *hex = luaL_checkstring(L, -1);
         lua_pop(L, 1);
-
-        if (idx1based <= 0)
-        {
-            idx1based = 1;
-        }
-        model.indices[i] = (uint16_t)(idx1based - 1); // convert to 0-based
+        layer.tileColors565[i] = parseHexColor(hex);
     }
 
-    self->models3d_.push_back(std::move(model));
-    int modelId = (int)self->models3d_.size(); // 1-based handle for Lua
+    self->tilemaps_.push_back(std::move(layer));
+    int tilemapId = (int)self->tilemaps_.size(); // 1-based handle for Lua
 
-    lua_pushinteger(L, modelId);
+    lua_pushinteger(L, tilemapId);
     return 1;
 }
 
-int LuaDriver::lge_create_3d_instance(lua_State *L)
+// Lua binding: lge.tilemap_set(tilemap_id, col, row, tile) - col/row are 1-based
+int LuaDriver::lge_tilemap_set(lua_State *L)
 {
     LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
     if (!self)
         return 0;
 
-    int modelId = (int)luaL_checkinteger(L, 1);
-    luaL_checktype(L, 2, LUA_TTABLE); // tri_colors
+    TilemapLayer *layer = self->checkTilemap(L, 1);
+    int col = (int)luaL_checkinteger(L, 2);
+    int row = (int)luaL_checkinteger(L, 3);
+    int tile = (int)luaL_checkinteger(L, 4);
 
-    if (modelId <= 0 || modelId > (int)self->models3d_.size())
-    {
-        return luaL_error(L, "lge.create_3d_instance: invalid model id %d", modelId);
-    }
+    layer->map.set(col - 1, row - 1, (uint8_t)std::max(0, std::min(255, tile)));
+    return 0;
+}
 
-    Instance3D instance;
-    instance.modelIndex = modelId - 1;
+// Lua binding: lge.tilemap_get(tilemap_id, col, row) -> tile
+int LuaDriver::lge_tilemap_get(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
 
-    const Model3D &model = self->models3d_[instance.modelIndex];
-    size_t faceCount = model.indices.size() / 3;
+    TilemapLayer *layer = self->checkTilemap(L, 1);
+    int col = (int)luaL_checkinteger(L, 2);
+    int row = (int)luaL_checkinteger(L, 3);
 
-    size_t clen = lua_rawlen(L, 2);
-    if (clen < faceCount)
-    {
-        Serial.printf("lge.create_3d_instance: got %u colors for %u faces, padding with white\n",
-                      (unsigned)clen, (unsigned)faceCount);
-    }
+    lua_pushinteger(L, layer->map.get(col - 1, row - 1));
+    return 1;
+}
 
-    instance.faceColors565.resize(faceCount);
+// Lua binding: lge.tilemap_fill(tilemap_id, tile)
+int LuaDriver::lge_tilemap_fill(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
 
-    for (size_t i = 0; i < faceCount; ++i)
-    {
-        uint16_t color565 = TFT_WHITE;
+    TilemapLayer *layer = self->checkTilemap(L, 1);
+    int tile = (int)luaL_checkinteger(L, 2);
 
-        if (i < clen)
-        {
-            lua_rawgeti(L, 2, (int)(i + 1));
-            const char *hex = luaL_checkstring(L, -1);
-            lua_pop(L, 1);
-            color565 = self->parseHexColor(hex);
-        }
+    layer->map.fill((uint8_t)std::max(0, std::min(255, tile)));
+    return 0;
+}
 
-        instance.faceColors565[i] = color565;
-    }
+// Lua binding: lge.tilemap_set_scroll(tilemap_id, scroll_x, scroll_y)
+int LuaDriver::lge_tilemap_set_scroll(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
 
-    self->instances3d_.push_back(std::move(instance));
-    int instanceId = (int)self->instances3d_.size(); // 1-based for Lua
+    TilemapLayer *layer = self->checkTilemap(L, 1);
+    int scrollX = (int)luaL_checknumber(L, 2);
+    int scrollY = (int)luaL_checknumber(L, 3);
 
-    lua_pushinteger(L, instanceId);
-    return 1;
+    layer->map.setScroll(scrollX, scrollY);
+    return 0;
 }
 
-int LuaDriver::lge_draw_3d_instance(lua_State *L)
+// Lua binding: lge.draw_tilemap(tilemap_id, x, y, w, h)
+// Only cells changed since the last draw are redrawn, unless the canvas was cleared,
+// the viewport moved or the scroll offset changed.
+int LuaDriver::lge_draw_tilemap(lua_State *L)
 {
     LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
     if (!self || !self->spr_)
         return 0;
 
-    int instanceId = (int)luaL_checkinteger(L, 1);
-    float wx = (float)luaL_checknumber(L, 2);     // world x
-    float wy = (float)luaL_checknumber(L, 3);     // world y
-    float wz = (float)luaL_checknumber(L, 4);     // world z (distance from camera)
-    float radius = (float)luaL_checknumber(L, 5); // desired approx 2D radius at depth wz
-    float ax = (float)luaL_checknumber(L, 6);
-    float ay = (float)luaL_checknumber(L, 7);
-    float az = (float)luaL_checknumber(L, 8);
+    TilemapLayer *layer = self->checkTilemap(L, 1);
+    const Tilemap &map = layer->map;
+    int x = (int)luaL_checknumber(L, 2);
+    int y = (int)luaL_checknumber(L, 3);
+    int w = (int)luaL_optnumber(L, 4, map.cols() * map.tileWidth());
+    int h = (int)luaL_optnumber(L, 5, map.rows() * map.tileHeight());
 
-    if (instanceId <= 0 || instanceId > (int)self->instances3d_.size())
-        return 0;
+    if (layer->canvasGeneration != self->canvasGeneration_)
+    {
+        layer->map.markAllDirty();
+        layer->canvasGeneration = self->canvasGeneration_;
+    }
 
-    Instance3D &inst = self->instances3d_[instanceId - 1];
-    if (inst.modelIndex < 0 || inst.modelIndex >= (int)self->models3d_.size())
-        return 0;
+    layer->map.collectSpans(x, y, w, h, self->tileSpans_);
 
-    Model3D &model = self->models3d_[inst.modelIndex];
+    for (const TileSpan &span : self->tileSpans_)
+    {
+        uint16_t color = layer->background565;
+        if (span.tile > 0 && span.tile <= layer->tileColors565.size())
+            color = layer->tileColors565[span.tile - 1];
+
+        self->spr_->fillRect(span.x, span.y, span.w, span.h, color);
+        self->addDirtyRegion(span.x, span.y, span.w, span.h);
+    }
 
-    const auto &srcVerts = model.vertices;
-    const auto &indices = model.indices;
+    return 0;
+}
 
-    size_t vertCount = srcVerts.size() / 3;
-    size_t faceCount = indices.size() / 3;
+ParticleEmitter *LuaDriver::checkEmitter(lua_State *L, int arg)
+{
+    int emitterId = (int)luaL_checkinteger(L, arg);
+    if (emitterId <= 0 || emitterId > (int)emitters_.size())
+    {
+        luaL_error(L, "lge: invalid emitter id %d", emitterId);
+        return nullptr;
+    }
+    return &emitters_[emitterId - 1];
+}
 
-    if (vertCount == 0 || faceCount == 0)
+// Lua binding: lge.create_emitter(params) -> emitter_id
+// params (all optional): capacity, life_min, life_max, speed_min, speed_max, angle, spread, gravity, size, shrink, color
+int LuaDriver::lge_create_emitter(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
         return 0;
 
-    // Ensure scratch buffers are large enough
-    // We now store 6 floats per vertex:
-    // [0]=camX, [1]=camY, [2]=camZ, [3]=screenX, [4]=screenY, [5]=unused
-    self->tempVertices3d_.resize(vertCount * 6);
-    self->visibleZ_.resize(faceCount);
-    self->visibleB1_.resize(faceCount);
-    self->visibleB2_.resize(faceCount);
-    self->visibleB3_.resize(faceCount);
-    self->visibleColor_.resize(faceCount);
+    EmitterParams params;
+    if (lua_istable(L, 1))
+    {
+        float capacity = optFieldNumber(L, 1, "capacity", (float)params.capacity);
+        if (!(capacity <= (float)PARTICLE_MAX_CAPACITY))
+            return luaL_error(L, "lge.create_emitter: capacity above the maximum of %d", PARTICLE_MAX_CAPACITY);
+        params.capacity = (int)capacity;
+        params.lifeMin = optFieldNumber(L, 1, "life_min", params.lifeMin);
+        params.lifeMax = optFieldNumber(L, 1, "life_max", params.lifeMax);
+        params.speedMin = optFieldNumber(L, 1, "speed_min", params.speedMin);
+        params.speedMax = optFieldNumber(L, 1, "speed_max", params.speedMax);
+        params.angle = optFieldNumber(L, 1, "angle", params.angle);
+        params.spread = optFieldNumber(L, 1, "spread", params.spread);
+        params.gravity = optFieldNumber(L, 1, "gravity", params.gravity);
+        params.size = (uint8_t)std::max(0.0f, std::min(255.0f, optFieldNumber(L, 1, "size", params.size)));
+
+        lua_getfield(L, 1, "shrink");
+        if (lua_isboolean(L, -1))
+            params.shrink = lua_toboolean(L, -1);
+        lua_pop(L, 1);
 
-    const float fov = self->fov3d_;
+        lua_getfield(L, 1, "color");
+        if (lua_isstring(L, -1))
+            params.color565 = parseHexColor(lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
 
-    // Prevent division by zero / behind-camera placement
-    if (wz < 1.0f)
-        wz = 1.0f;
+    self->emitters_.emplace_back(params, esp_random());
+    int emitterId = (int)self->emitters_.size(); // 1-based handle for Lua
 
-    // Approximate scale so that projected radius ~ 'radius' at depth ~ wz
-    // visual_radius ≈ scale * (fov / wz)  =>  scale ≈ radius * (wz / fov)
-    float baseScale = radius * (wz / fov);
+    lua_pushinteger(L, emitterId);
+    return 1;
+}
 
-    // Precompute trig
-    float cos_x = std::cos(ax);
-    float sin_x = std::sin(ax);
-    float cos_y = std::cos(ay);
-    float sin_y = std::sin(ay);
-    float cos_z = std::cos(az);
-    float sin_z = std::sin(az);
+// Lua binding: lge.emitter_burst(emitter_id, x, y, count, color) -> spawned
+int LuaDriver::lge_emitter_burst(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
 
-    // Projection center = center of sprite
-    float centerX = self->spr_->width() * 0.5f;
-    float centerY = self->spr_->height() * 0.5f;
+    ParticleEmitter *emitter = self->checkEmitter(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    int count = (int)luaL_optinteger(L, 4, 8);
+    uint16_t color = emitter->params().color565;
+    if (lua_isstring(L, 5))
+        color = parseHexColor(lua_tostring(L, 5));
 
-    // 1) Transform all vertices: model -> scaled -> rotated -> world -> camera -> screen
-    for (size_t i = 0; i < vertCount; ++i)
-    {
-        size_t srcBase = i * 3;
-        size_t tmpBase = i * 6;
+    lua_pushinteger(L, emitter->burst(x, y, count, color));
+    return 1;
+}
 
-        // Model-space
-        float vx = srcVerts[srcBase + 0] * baseScale;
-        float vy = srcVerts[srcBase + 1] * baseScale;
-        float vz = srcVerts[srcBase + 2] * baseScale;
+// Lua binding: lge.update_emitter(emitter_id, dt) - dt in seconds
+int LuaDriver::lge_update_emitter(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
 
-        // Rotate: Rx, then Ry, then Rz
-        float y1 = vy * cos_x - vz * sin_x;
-        float z1 = vy * sin_x + vz * cos_x;
-        float x1 = vx;
+    ParticleEmitter *emitter = self->checkEmitter(L, 1);
+    float dt = (float)luaL_checknumber(L, 2);
 
-        float x2 = x1 * cos_y + z1 * sin_y;
-        float z2 = -x1 * sin_y + z1 * cos_y;
-        float y2 = y1;
+    emitter->update(dt);
+    return 0;
+}
 
-        float x3 = x2 * cos_z - y2 * sin_z;
-        float y3 = x2 * sin_z + y2 * cos_z;
-        float z3 = z2;
+// Lua binding: lge.draw_emitter(emitter_id)
+// All live particles are drawn in one pass and marked dirty as a single bounding region.
+int LuaDriver::lge_draw_emitter(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self || !self->spr_)
+        return 0;
 
-        // World space: translate by (wx, wy, wz)
-        float camX = x3 + wx;
-        float camY = y3 + wy;
-        float camZ = z3 + wz; // camera at origin, looking along +Z
+    ParticleEmitter *emitter = self->checkEmitter(L, 1);
+    int count = emitter->count();
+    if (count == 0)
+        return 0;
 
-        if (camZ < 0.001f)
-            camZ = 0.001f;
+    int dirtyRectMinX = self->spr_->width();
+    int dirtyRectMinY = self->spr_->height();
+    int dirtyRectMaxX = -1;
+    int dirtyRectMaxY = -1;
 
-        float z_factor = fov / camZ;
+    for (int i = 0; i < count; ++i)
+    {
+        int x = emitter->pixelX(i);
+        int y = emitter->pixelY(i);
+        int r = emitter->radius(i);
 
-        float sx = camX * z_factor + centerX;
-        float sy = camY * z_factor + centerY;
+        if (r <= 0)
+            self->spr_->drawPixel(x, y, emitter->color(i));
+        else
+            self->spr_->fillCircle(x, y, r, emitter->color(i));
+
+        if (x - r < dirtyRectMinX)
+            dirtyRectMinX = x - r;
+        if (y - r < dirtyRectMinY)
+            dirtyRectMinY = y - r;
+        if (x + r > dirtyRectMaxX)
+            dirtyRectMaxX = x + r;
+        if (y + r > dirtyRectMaxY)
+            dirtyRectMaxY = y + r;
+    }
+
+    self->addDirtyRegion(dirtyRectMinX, dirtyRectMinY, dirtyRectMaxX - dirtyRectMinX + 1, dirtyRectMaxY - dirtyRectMinY + 1);
+    return 0;
+}
+
+// Lua binding: lge.emitter_count(emitter_id) -> live particles
+int LuaDriver::lge_emitter_count(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    ParticleEmitter *emitter = self->checkEmitter(L, 1);
+    lua_pushinteger(L, emitter->count());
+    return 1;
+}
+
+// Lua binding: lge.emitter_clear(emitter_id)
+int LuaDriver::lge_emitter_clear(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    ParticleEmitter *emitter = self->checkEmitter(L, 1);
+    emitter->clear();
+    return 0;
+}
+
+void LuaDriver::pushResultTable(lua_State *L, int arg, int &ref)
+{
+    if (lua_istable(L, arg))
+    {
+        lua_pushvalue(L, arg);
+        return;
+    }
+
+    if (ref == LUA_NOREF)
+    {
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        ref = luaL_ref(L, LUA_REGISTRYINDEX);
+        return;
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+}
+
+// Write 0-based ids as 1-based Lua ids into the table on top of the stack, terminated by nil
+static void writeIdResults(lua_State *L, const std::vector<int> &ids)
+{
+    int n = (int)ids.size();
+    for (int i = 0; i < n; ++i)
+    {
+        lua_pushinteger(L, ids[i] + 1);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushnil(L);
+    lua_rawseti(L, -2, n + 1);
+}
+
+LuaDriver::CollisionLayer *LuaDriver::checkCollisionWorld(lua_State *L, int arg)
+{
+    int worldId = (int)luaL_checkinteger(L, arg);
+    if (worldId <= 0 || worldId > (int)collisionWorlds_.size())
+    {
+        luaL_error(L, "lge: invalid collision world id %d", worldId);
+        return nullptr;
+    }
+    return &collisionWorlds_[worldId - 1];
+}
+
+// Lua binding: lge.collision_world(cell_size) -> world_id
+int LuaDriver::lge_collision_world(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    float cellSize = (float)luaL_optnumber(L, 1, 32.0);
+
+    self->collisionWorlds_.push_back({CollisionWorld(cellSize), LUA_NOREF});
+    int worldId = (int)self->collisionWorlds_.size(); // 1-based handle for Lua
+
+    lua_pushinteger(L, worldId);
+    return 1;
+}
+
+// Lua binding: lge.collision_insert(world_id, x, y, r, category, mask) -> body_id (circle)
+int LuaDriver::lge_collision_insert(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    CollisionLayer *layer = self->checkCollisionWorld(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float r = (float)luaL_checknumber(L, 4);
+    uint16_t category = (uint16_t)luaL_optinteger(L, 5, 1);
+    uint16_t mask = (uint16_t)luaL_optinteger(L, 6, 0xFFFF);
+
+    lua_pushinteger(L, layer->world.insertCircle(x, y, r, category, mask) + 1);
+    return 1;
+}
+
+// Lua binding: lge.collision_insert_rect(world_id, x, y, w, h, category, mask) -> body_id
+int LuaDriver::lge_collision_insert_rect(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    CollisionLayer *layer = self->checkCollisionWorld(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float w = (float)luaL_checknumber(L, 4);
+    float h = (float)luaL_checknumber(L, 5);
+    uint16_t category = (uint16_t)luaL_optinteger(L, 6, 1);
+    uint16_t mask = (uint16_t)luaL_optinteger(L, 7, 0xFFFF);
+
+    lua_pushinteger(L, layer->world.insertRect(x, y, w, h, category, mask) + 1);
+    return 1;
+}
+
+// Lua binding: lge.collision_move(world_id, body_id, x, y, w, h) - w/h optional (w = radius for circles)
+int LuaDriver::lge_collision_move(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    CollisionLayer *layer = self->checkCollisionWorld(L, 1);
+    int bodyId = (int)luaL_checkinteger(L, 2);
+    float x = (float)luaL_checknumber(L, 3);
+    float y = (float)luaL_checknumber(L, 4);
+    float w = (float)luaL_optnumber(L, 5, -1.0);
+    float h = (float)luaL_optnumber(L, 6, -1.0);
+
+    lua_pushboolean(L, layer->world.move(bodyId - 1, x, y, w, h));
+    return 1;
+}
+
+// Lua binding: lge.collision_remove(world_id, body_id)
+int LuaDriver::lge_collision_remove(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    CollisionLayer *layer = self->checkCollisionWorld(L, 1);
+    int bodyId = (int)luaL_checkinteger(L, 2);
+
+    lua_pushboolean(L, layer->world.remove(bodyId - 1));
+    return 1;
+}
+
+// Lua binding: lge.collision_query(world_id, x, y, w, h, out) -> (ids, count)
+int LuaDriver::lge_collision_query(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    CollisionLayer *layer = self->checkCollisionWorld(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float w = (float)luaL_checknumber(L, 4);
+    float h = (float)luaL_checknumber(L, 5);
+
+    layer->world.queryRect(x, y, w, h, self->collisionResults_);
+
+    pushResultTable(L, 6, layer->resultRef);
+    writeIdResults(L, self->collisionResults_);
+    lua_pushinteger(L, (lua_Integer)self->collisionResults_.size());
+    return 2;
+}
+
+// Lua binding: lge.collision_pairs(world_id, out) -> (flat_pairs, pair_count)
+// flat_pairs = {a1, b1, a2, b2, ...}
+int LuaDriver::lge_collision_pairs(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    CollisionLayer *layer = self->checkCollisionWorld(L, 1);
+
+    layer->world.collectPairs(self->collisionResults_);
+
+    pushResultTable(L, 2, layer->resultRef);
+    writeIdResults(L, self->collisionResults_);
+    lua_pushinteger(L, (lua_Integer)(self->collisionResults_.size() / 2));
+    return 2;
+}
+
+LuaDriver::PhysicsLayer *LuaDriver::checkPhysicsWorld(lua_State *L, int arg)
+{
+    int worldId = (int)luaL_checkinteger(L, arg);
+    if (worldId <= 0 || worldId > (int)physicsWorlds_.size())
+    {
+        luaL_error(L, "lge: invalid physics world id %d", worldId);
+        return nullptr;
+    }
+    return &physicsWorlds_[worldId - 1];
+}
+
+// Lua binding: lge.physics_world(params) -> world_id
+// params (all optional): capacity, width, height, walls, gravity_x, gravity_y, fixed_dt, max_substeps
+int LuaDriver::lge_physics_world(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsParams params;
+    if (self->tft_)
+    {
+        params.width = self->tft_->width();
+        params.height = self->tft_->height();
+    }
+
+    if (lua_istable(L, 1))
+    {
+        params.capacity = (int)optFieldNumber(L, 1, "capacity", (float)params.capacity);
+        params.width = optFieldNumber(L, 1, "width", params.width);
+        params.height = optFieldNumber(L, 1, "height", params.height);
+        params.gravityX = optFieldNumber(L, 1, "gravity_x", params.gravityX);
+        params.gravityY = optFieldNumber(L, 1, "gravity_y", params.gravityY);
+        params.fixedDt = optFieldNumber(L, 1, "fixed_dt", params.fixedDt);
+        params.maxSubsteps = (int)optFieldNumber(L, 1, "max_substeps", (float)params.maxSubsteps);
+
+        lua_getfield(L, 1, "walls");
+        if (lua_isboolean(L, -1))
+            params.walls = lua_toboolean(L, -1);
+        lua_pop(L, 1);
+    }
+
+    self->physicsWorlds_.push_back({PhysicsWorld(params), LUA_NOREF});
+    int worldId = (int)self->physicsWorlds_.size(); // 1-based handle for Lua
+
+    lua_pushinteger(L, worldId);
+    return 1;
+}
+
+// Lua binding: lge.physics_add_circle(world_id, x, y, r, vx, vy, mass, restitution) -> body_id | nil
+int LuaDriver::lge_physics_add_circle(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsLayer *layer = self->checkPhysicsWorld(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float r = (float)luaL_checknumber(L, 4);
+    float vx = (float)luaL_optnumber(L, 5, 0.0);
+    float vy = (float)luaL_optnumber(L, 6, 0.0);
+    float mass = (float)luaL_optnumber(L, 7, 1.0);
+    float restitution = (float)luaL_optnumber(L, 8, 1.0);
+
+    int id = layer->world.addCircle(x, y, r, vx, vy, mass, restitution);
+    if (id < 0)
+    {
+        Serial.println("lge.physics_add_circle: world is full");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_pushinteger(L, id + 1);
+    return 1;
+}
+
+// Lua binding: lge.physics_add_rect(world_id, x, y, w, h, vx, vy, mass, restitution) -> body_id | nil
+int LuaDriver::lge_physics_add_rect(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsLayer *layer = self->checkPhysicsWorld(L, 1);
+    float x = (float)luaL_checknumber(L, 2);
+    float y = (float)luaL_checknumber(L, 3);
+    float w = (float)luaL_checknumber(L, 4);
+    float h = (float)luaL_checknumber(L, 5);
+    float vx = (float)luaL_optnumber(L, 6, 0.0);
+    float vy = (float)luaL_optnumber(L, 7, 0.0);
+    float mass = (float)luaL_optnumber(L, 8, 1.0);
+    float restitution = (float)luaL_optnumber(L, 9, 1.0);
+
+    int id = layer->world.addRect(x, y, w, h, vx, vy, mass, restitution);
+    if (id < 0)
+    {
+        Serial.println("lge.physics_add_rect: world is full");
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_pushinteger(L, id + 1);
+    return 1;
+}
+
+// Lua binding: lge.physics_remove(world_id, body_id)
+int LuaDriver::lge_physics_remove(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsLayer *layer = self->checkPhysicsWorld(L, 1);
+    int bodyId = (int)luaL_checkinteger(L, 2);
+
+    lua_pushboolean(L, layer->world.remove(bodyId - 1));
+    return 1;
+}
+
+// Lua binding: lge.physics_set_position(world_id, body_id, x, y)
+int LuaDriver::lge_physics_set_position(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsLayer *layer = self->checkPhysicsWorld(L, 1);
+    int bodyId = (int)luaL_checkinteger(L, 2);
+    float x = (float)luaL_checknumber(L, 3);
+    float y = (float)luaL_checknumber(L, 4);
+
+    lua_pushboolean(L, layer->world.setPosition(bodyId - 1, x, y));
+    return 1;
+}
+
+// Lua binding: lge.physics_set_velocity(world_id, body_id, vx, vy)
+int LuaDriver::lge_physics_set_velocity(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsLayer *layer = self->checkPhysicsWorld(L, 1);
+    int bodyId = (int)luaL_checkinteger(L, 2);
+    float vx = (float)luaL_checknumber(L, 3);
+    float vy = (float)luaL_checknumber(L, 4);
+
+    lua_pushboolean(L, layer->world.setVelocity(bodyId - 1, vx, vy));
+    return 1;
+}
+
+// Lua binding: lge.physics_get_body(world_id, body_id) -> x, y, vx, vy | nil
+int LuaDriver::lge_physics_get_body(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsLayer *layer = self->checkPhysicsWorld(L, 1);
+    int id = (int)luaL_checkinteger(L, 2) - 1;
+    if (!layer->world.isValid(id))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_pushnumber(L, layer->world.x(id));
+    lua_pushnumber(L, layer->world.y(id));
+    lua_pushnumber(L, layer->world.vx(id));
+    lua_pushnumber(L, layer->world.vy(id));
+    return 4;
+}
+
+// Lua binding: lge.physics_step(world_id, dt) -> steps - dt in seconds
+int LuaDriver::lge_physics_step(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsLayer *layer = self->checkPhysicsWorld(L, 1);
+    float dt = (float)luaL_checknumber(L, 2);
+
+    lua_pushinteger(L, layer->world.step(dt));
+    return 1;
+}
+
+// Lua binding: lge.physics_get_positions(world_id, out) -> (flat_positions, count)
+// flat_positions = {x1, y1, x2, y2, ...} indexed by body id, count = highest body id in use
+int LuaDriver::lge_physics_get_positions(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    PhysicsLayer *layer = self->checkPhysicsWorld(L, 1);
+    const PhysicsWorld &world = layer->world;
+    int count = world.slotCount();
+
+    pushResultTable(L, 2, layer->resultRef);
+    for (int i = 0; i < count; ++i)
+    {
+        lua_pushnumber(L, world.x(i));
+        lua_rawseti(L, -2, 2 * i + 1);
+        lua_pushnumber(L, world.y(i));
+        lua_rawseti(L, -2, 2 * i + 2);
+    }
+    lua_pushinteger(L, count);
+    return 2;
+}
+
+LuaDriver::GridLayer *LuaDriver::checkGrid(lua_State *L, int arg)
+{
+    int gridId = (int)luaL_checkinteger(L, arg);
+    if (gridId <= 0 || gridId > (int)grids_.size())
+    {
+        luaL_error(L, "lge: invalid grid id %d", gridId);
+        return nullptr;
+    }
+    return &grids_[gridId - 1];
+}
+
+// Write grid kernel results into the table on top of the stack, terminated by nil.
+// Every value in a group of `stride` whose position is set in `coordMask` is converted to 1-based.
+static void writeGridResults(lua_State *L, const std::vector<int> &values, int stride, unsigned coordMask)
+{
+    int n = (int)values.size();
+    for (int i = 0; i < n; ++i)
+    {
+        int value = values[i];
+        if (coordMask & (1u << (i % stride)))
+            value += 1;
+        lua_pushinteger(L, value);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushnil(L);
+    lua_rawseti(L, -2, n + 1);
+}
+
+// Lua binding: lge.create_grid(cols, rows) -> grid_id
+int LuaDriver::lge_create_grid(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    int cols = (int)luaL_checkinteger(L, 1);
+    int rows = (int)luaL_checkinteger(L, 2);
+    if (cols <= 0 || rows <= 0 || cols > 255 || rows > 255)
+    {
+        return luaL_error(L, "lge.create_grid: invalid size %dx%d", cols, rows);
+    }
+
+    self->grids_.push_back({BoardGrid(cols, rows), LUA_NOREF});
+    int gridId = (int)self->grids_.size(); // 1-based handle for Lua
+
+    lua_pushinteger(L, gridId);
+    return 1;
+}
+
+// Lua binding: lge.grid_get(grid_id, col, row) -> value - col/row are 1-based
+int LuaDriver::lge_grid_get(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    GridLayer *layer = self->checkGrid(L, 1);
+    int col = (int)luaL_checkinteger(L, 2);
+    int row = (int)luaL_checkinteger(L, 3);
+
+    lua_pushinteger(L, layer->grid.get(col - 1, row - 1));
+    return 1;
+}
+
+// Lua binding: lge.grid_set(grid_id, col, row, value)
+int LuaDriver::lge_grid_set(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    GridLayer *layer = self->checkGrid(L, 1);
+    int col = (int)luaL_checkinteger(L, 2);
+    int row = (int)luaL_checkinteger(L, 3);
+    int value = (int)luaL_checkinteger(L, 4);
+
+    layer->grid.set(col - 1, row - 1, (uint8_t)std::max(0, std::min(255, value)));
+    return 0;
+}
+
+// Lua binding: lge.grid_fill(grid_id, value)
+int LuaDriver::lge_grid_fill(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    GridLayer *layer = self->checkGrid(L, 1);
+    int value = (int)luaL_checkinteger(L, 2);
+
+    layer->grid.fill((uint8_t)std::max(0, std::min(255, value)));
+    return 0;
+}
+
+// Lua binding: lge.grid_swap(grid_id, col1, row1, col2, row2) -> ok
+int LuaDriver::lge_grid_swap(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    GridLayer *layer = self->checkGrid(L, 1);
+    int col1 = (int)luaL_checkinteger(L, 2);
+    int row1 = (int)luaL_checkinteger(L, 3);
+    int col2 = (int)luaL_checkinteger(L, 4);
+    int row2 = (int)luaL_checkinteger(L, 5);
+
+    lua_pushboolean(L, layer->grid.swap(col1 - 1, row1 - 1, col2 - 1, row2 - 1));
+    return 1;
+}
+
+// Lua binding: lge.grid_find_runs(grid_id, min_len, out) -> (runs, count)
+// runs = {col1, row1, len1, dir1, col2, ...}, dir 0 = horizontal, 1 = vertical
+int LuaDriver::lge_grid_find_runs(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    GridLayer *layer = self->checkGrid(L, 1);
+    int minLen = (int)luaL_optinteger(L, 2, 3);
+
+    self->gridResults_.clear();
+    int count = layer->grid.findRuns(minLen, self->gridResults_);
+
+    pushResultTable(L, 3, layer->resultRef);
+    writeGridResults(L, self->gridResults_, 4, 0x3); // col, row
+    lua_pushinteger(L, count);
+    return 2;
+}
+
+// Lua binding: lge.grid_collapse_columns(grid_id, out) -> (moves, count)
+// moves = {col1, from_row1, to_row1, col2, ...}
+int LuaDriver::lge_grid_collapse_columns(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    GridLayer *layer = self->checkGrid(L, 1);
+
+    self->gridResults_.clear();
+    int count = layer->grid.collapseColumns(self->gridResults_);
+
+    pushResultTable(L, 2, layer->resultRef);
+    writeGridResults(L, self->gridResults_, 3, 0x7); // col, from_row, to_row
+    lua_pushinteger(L, count);
+    return 2;
+}
+
+// Lua binding: lge.grid_flood_fill(grid_id, col, row, value, diagonal) -> cells_filled
+int LuaDriver::lge_grid_flood_fill(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    GridLayer *layer = self->checkGrid(L, 1);
+    int col = (int)luaL_checkinteger(L, 2);
+    int row = (int)luaL_checkinteger(L, 3);
+    int value = (int)luaL_checkinteger(L, 4);
+    bool diagonal = lua_toboolean(L, 5);
+
+    lua_pushinteger(L, layer->grid.floodFill(col - 1, row - 1, (uint8_t)std::max(0, std::min(255, value)), diagonal));
+    return 1;
+}
+
+// Lua binding: lge.grid_count_neighbors(grid_id, col, row, value, diagonal) -> count
+int LuaDriver::lge_grid_count_neighbors(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    GridLayer *layer = self->checkGrid(L, 1);
+    int col = (int)luaL_checkinteger(L, 2);
+    int row = (int)luaL_checkinteger(L, 3);
+    int value = (int)luaL_checkinteger(L, 4);
+    bool diagonal = lua_toboolean(L, 5);
+
+    lua_pushinteger(L, layer->grid.countNeighbors(col - 1, row - 1, (uint8_t)std::max(0, std::min(255, value)), diagonal));
+    return 1;
+}
+
+int LuaDriver::lge_set_3d_camera(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    self->fov3d_ = (float)luaL_checknumber(L, 1);
+    self->camDist3d_ = (float)luaL_checknumber(L, 2);
+    self->view3dGeneration_++;
+
+    return 0;
+}
+
+int LuaDriver::lge_set_3d_view(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    float ex = (float)luaL_checknumber(L, 1);
+    float ey = (float)luaL_checknumber(L, 2);
+    float ez = (float)luaL_checknumber(L, 3);
+    float tx = (float)luaL_checknumber(L, 4);
+    float ty = (float)luaL_checknumber(L, 5);
+    float tz = (float)luaL_checknumber(L, 6);
+    float ux = (float)luaL_optnumber(L, 7, 0.0f);
+    float uy = (float)luaL_optnumber(L, 8, -1.0f); // world Y grows downwards, like screen Y
+    float uz = (float)luaL_optnumber(L, 9, 0.0f);
+
+    // Forward axis, camera +Z
+    float fx = tx - ex;
+    float fy = ty - ey;
+    float fz = tz - ez;
+    float flen = std::sqrt(fx * fx + fy * fy + fz * fz);
+    if (flen < 1e-6f)
+        return luaL_error(L, "lge.set_3d_view: eye and target are the same point");
+    fx /= flen;
+    fy /= flen;
+    fz /= flen;
+
+    // Down axis, camera +Y: the part of -up perpendicular to forward
+    float ud = ux * fx + uy * fy + uz * fz;
+    float dx = -(ux - ud * fx);
+    float dy = -(uy - ud * fy);
+    float dz = -(uz - ud * fz);
+    float dlen = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (dlen < 1e-6f)
+        return luaL_error(L, "lge.set_3d_view: up is parallel to the view direction");
+    dx /= dlen;
+    dy /= dlen;
+    dz /= dlen;
+
+    // Right axis, camera +X = down x forward
+    float rx = dy * fz - dz * fy;
+    float ry = dz * fx - dx * fz;
+    float rz = dx * fy - dy * fx;
+
+    // Rows are the camera axes, translation moves the eye to the origin
+    float *v = self->view3d_;
+    v[0] = rx;
+    v[1] = ry;
+    v[2] = rz;
+    v[3] = -(rx * ex + ry * ey + rz * ez);
+    v[4] = dx;
+    v[5] = dy;
+    v[6] = dz;
+    v[7] = -(dx * ex + dy * ey + dz * ez);
+    v[8] = fx;
+    v[9] = fy;
+    v[10] = fz;
+    v[11] = -(fx * ex + fy * ey + fz * ez);
+
+    self->view3dGeneration_++;
+    return 0;
+}
+
+// Row-major rotation matrix equivalent to rotating about X, then Y, then Z
+static void buildRotation3d(float ax, float ay, float az, float m[9])
+{
+    float cx, sx, cy, sy, cz, sz;
+    fastSinCos(ax, sx, cx);
+    fastSinCos(ay, sy, cy);
+    fastSinCos(az, sz, cz);
+
+    m[0] = cy * cz;
+    m[1] = sx * sy * cz - cx * sz;
+    m[2] = cx * sy * cz + sx * sz;
+    m[3] = cy * sz;
+    m[4] = sx * sy * sz + cx * cz;
+    m[5] = cx * sy * sz - sx * cz;
+    m[6] = -sy;
+    m[7] = sx * cy;
+    m[8] = cx * cy;
+}
+
+// Unit normal per triangle, (v2 - v1) x (v3 - v1), and its plane offset d = -n . v1.
+// Degenerate faces and faces with out-of-range indices get a zero plane and are always culled.
+void LuaDriver::computeFacePlanes(Model3D &model)
+{
+    Mesh3D &mesh = model.lods[0];
+    size_t vertCount = mesh.vertexCount();
+    size_t faceCount = mesh.faceCount();
+    model.normalStore.assign(faceCount * 3, 0);
+    model.planeStore.assign(faceCount, 0.0f);
+    mesh.faceNormals = model.normalStore.data();
+    mesh.facePlaneD = model.planeStore.data();
+
+    for (size_t f = 0; f < faceCount; ++f)
+    {
+        size_t i1 = mesh.index(f * 3 + 0);
+        size_t i2 = mesh.index(f * 3 + 1);
+        size_t i3 = mesh.index(f * 3 + 2);
+        if (i1 >= vertCount || i2 >= vertCount || i3 >= vertCount)
+            continue;
+
+        // Planes come from the quantized positions, so culling matches what is drawn
+        float p1[3], p2[3], p3[3];
+        mesh.position(i1, p1);
+        mesh.position(i2, p2);
+        mesh.position(i3, p3);
+
+        float e1x = p2[0] - p1[0];
+        float e1y = p2[1] - p1[1];
+        float e1z = p2[2] - p1[2];
+        float e2x = p3[0] - p1[0];
+        float e2y = p3[1] - p1[1];
+        float e2z = p3[2] - p1[2];
+
+        float nx = e1y * e2z - e1z * e2y;
+        float ny = e1z * e2x - e1x * e2z;
+        float nz = e1x * e2y - e1y * e2x;
+
+        float nlen = std::sqrt(nx * nx + ny * ny + nz * nz);
+        if (nlen > 1e-6f)
+        {
+            int16_t *n = &model.normalStore[f * 3];
+            n[0] = (int16_t)std::lround(nx / nlen * NORMAL_ONE_3D);
+            n[1] = (int16_t)std::lround(ny / nlen * NORMAL_ONE_3D);
+            n[2] = (int16_t)std::lround(nz / nlen * NORMAL_ONE_3D);
+
+            // Offset for the stored normal, in the same Q1.15 units
+            model.planeStore[f] = -(n[0] * p1[0] + n[1] * p1[1] + n[2] * p1[2]);
+        }
+    }
+}
+
+// Sphere around the vertex bounding box center, enclosing every vertex
+void LuaDriver::computeBoundingSphere(Mesh3D &mesh)
+{
+    size_t vertCount = mesh.vertexCount();
+    mesh.boundCenter[0] = mesh.boundCenter[1] = mesh.boundCenter[2] = 0.0f;
+    mesh.boundRadius = 0.0f;
+    if (vertCount == 0)
+        return;
+
+    float minV[3], maxV[3];
+    mesh.position(0, minV);
+    mesh.position(0, maxV);
+    for (size_t i = 1; i < vertCount; ++i)
+    {
+        float p[3];
+        mesh.position(i, p);
+        for (int k = 0; k < 3; ++k)
+        {
+            minV[k] = std::min(minV[k], p[k]);
+            maxV[k] = std::max(maxV[k], p[k]);
+        }
+    }
+
+    for (int k = 0; k < 3; ++k)
+        mesh.boundCenter[k] = (minV[k] + maxV[k]) * 0.5f;
+
+    float maxDist2 = 0.0f;
+    for (size_t i = 0; i < vertCount; ++i)
+    {
+        float p[3];
+        mesh.position(i, p);
+        float dx = p[0] - mesh.boundCenter[0];
+        float dy = p[1] - mesh.boundCenter[1];
+        float dz = p[2] - mesh.boundCenter[2];
+        maxDist2 = std::max(maxDist2, dx * dx + dy * dy + dz * dz);
+    }
+    mesh.boundRadius = std::sqrt(maxDist2);
+}
+
+// Unit normal per vertex for every level: sum of the (v2 - v1) x (v3 - v1) of its faces, which weights
+// them by area. Vertices without a usable face get a zero normal and only receive ambient light.
+void LuaDriver::computeVertexNormals(Model3D &model)
+{
+    size_t total = 0;
+    for (const Mesh3D &mesh : model.lods)
+        total += mesh.vertexCount();
+    model.vertexNormalStore.assign(total * 3, 0);
+
+    std::vector<float> sums;
+    size_t offset = 0;
+    for (Mesh3D &mesh : model.lods)
+    {
+        size_t vertCount = mesh.vertexCount();
+        sums.assign(vertCount * 3, 0.0f);
+
+        for (size_t f = 0; f < mesh.faceCount(); ++f)
+        {
+            size_t idx[3] = {mesh.index(f * 3 + 0), mesh.index(f * 3 + 1), mesh.index(f * 3 + 2)};
+            float p1[3], p2[3], p3[3];
+            mesh.position(idx[0], p1);
+            mesh.position(idx[1], p2);
+            mesh.position(idx[2], p3);
+
+            float e1[3] = {p2[0] - p1[0], p2[1] - p1[1], p2[2] - p1[2]};
+            float e2[3] = {p3[0] - p1[0], p3[1] - p1[1], p3[2] - p1[2]};
+            float n[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                          e1[2] * e2[0] - e1[0] * e2[2],
+                          e1[0] * e2[1] - e1[1] * e2[0]};
+
+            for (int k = 0; k < 3; ++k)
+            {
+                sums[idx[k] * 3 + 0] += n[0];
+                sums[idx[k] * 3 + 1] += n[1];
+                sums[idx[k] * 3 + 2] += n[2];
+            }
+        }
+
+        int16_t *out = &model.vertexNormalStore[offset * 3];
+        for (size_t i = 0; i < vertCount; ++i)
+        {
+            const float *n = &sums[i * 3];
+            float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (len > 1e-12f)
+            {
+                float inv = NORMAL_ONE_3D / len;
+                out[i * 3 + 0] = (int16_t)std::lround(n[0] * inv);
+                out[i * 3 + 1] = (int16_t)std::lround(n[1] * inv);
+                out[i * 3 + 2] = (int16_t)std::lround(n[2] * inv);
+            }
+        }
+
+        mesh.vertexNormals = out;
+        offset += vertCount;
+    }
+}
+
+int LuaDriver::lge_create_3d_model(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    luaL_checktype(L, 1, LUA_TTABLE); // vertices_flat
+    luaL_checktype(L, 2, LUA_TTABLE); // faces_flat
+    self->reserve3dModel(L);
+
+    size_t vlen = lua_rawlen(L, 1);
+    if (vlen % 3 != 0)
+    {
+        Serial.printf("lge.create_3d_model: vertex array length %u is not multiple of 3\n", (unsigned)vlen);
+    }
+    size_t flen = lua_rawlen(L, 2);
+    if (flen % 3 != 0)
+    {
+        Serial.printf("lge.create_3d_model: face index array length %u is not multiple of 3\n", (unsigned)flen);
+    }
+    size_t vertCount = vlen / 3;
+    size_t indexCount = flen / 3 * 3;
+
+    // Lua errors longjmp past C++ destructors: check both tables before any object owning memory exists
+    float maxAbs = 0.0f;
+    for (size_t i = 0; i < vertCount * 3; ++i)
+    {
+        int isNumber = 0;
+        lua_rawgeti(L, 1, (int)(i + 1));
+        float v = (float)lua_tonumberx(L, -1, &isNumber);
+        lua_pop(L, 1);
+        if (!isNumber)
+            return luaL_error(L, "lge.create_3d_model: vertex coordinate %d is not a number", (int)(i + 1));
+        maxAbs = std::max(maxAbs, std::fabs(v));
+    }
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        int isInteger = 0;
+        lua_rawgeti(L, 2, (int)(i + 1));
+        lua_tointegerx(L, -1, &isInteger);
+        lua_pop(L, 1);
+        if (!isInteger)
+            return luaL_error(L, "lge.create_3d_model: face index %d is not an integer", (int)(i + 1));
+    }
+
+    Model3D model;
+    Mesh3D mesh;
+
+    // --- Read vertices ---
+    // Quantize to int16, the largest coordinate maps to +-32767
+    mesh.vertexScale = (maxAbs > 0.0f) ? maxAbs / 32767.0f : 1.0f;
+    model.vertexStore.resize(vertCount * 3);
+    for (size_t i = 0; i < model.vertexStore.size(); ++i)
+    {
+        lua_rawgeti(L, 1, (int)(i + 1));
+        float v = (float)lua_tonumber(L, -1);
+        lua_pop(L, 1);
+        model.vertexStore[i] = (int16_t)std::lround(v / mesh.vertexScale);
+    }
+    mesh.vertices = model.vertexStore.data();
+    mesh.vertCount = vertCount;
+
+    // --- Read faces (indices) ---
+    std::vector<uint16_t> indices(indexCount);
+    for (size_t f = 0; f < indices.size(); f += 3)
+    {
+        bool valid = true;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            lua_rawgeti(L, 2, (int)(f + k + 1));
+            lua_Integer idx1based = lua_tointeger(L, -1);
+            lua_pop(L, 1);
+
+            if (idx1based <= 0)
+            {
+                idx1based = 1;
+            }
+            if (idx1based > (lua_Integer)vertCount)
+            {
+                valid = false;
+            }
+            indices[f + k] = (uint16_t)(idx1based - 1); // convert to 0-based
+        }
+
+        // A face referencing a missing vertex becomes degenerate (never drawn)
+        if (!valid)
+            indices[f] = indices[f + 1] = indices[f + 2] = 0;
+    }
+
+    // 8-bit indices whenever every vertex fits
+    if (vertCount <= 256)
+    {
+        model.index8Store.assign(indices.begin(), indices.end());
+        mesh.indices8 = model.index8Store.data();
+    }
+    else
+    {
+        model.index16Store.swap(indices);
+        mesh.indices16 = model.index16Store.data();
+    }
+    mesh.faceCnt = flen / 3;
+
+    model.lods.push_back(mesh);
+    computeFacePlanes(model);
+    computeBoundingSphere(model.lods[0]);
+
+    int modelId = self->add3dModel(std::move(model));
+
+    lua_pushinteger(L, modelId);
+    return 1;
+}
+
+// Lua binding: lge.load_3d_model(path_or_blob)
+// The mesh is used in place: a blob string is pinned in the registry, an embedded mesh stays in flash,
+// only a SPIFFS file (not memory-mapped) is read once into a userdata pinned the same way.
+// Lua errors longjmp past C++ destructors, so no object owning memory is alive until every check has passed.
+int LuaDriver::lge_load_3d_model(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    size_t len = 0;
+    const char *arg = luaL_checklstring(L, 1, &len);
+
+    const void *data = nullptr;
+    size_t size = 0;
+    bool isString = isMeshBlob(arg, len);
+    bool isFile = false;
+
+    if (isString)
+    {
+        data = arg;
+        size = len;
+    }
+    else
+    {
+        for (int i = 0; mesh_names[i]; ++i)
+        {
+            if (strcmp(mesh_names[i], arg) == 0)
+            {
+                data = mesh_blobs[i];
+                size = mesh_blob_sizes[i];
+                break;
+            }
+        }
+    }
+
+    if (!data)
+    {
+        // Each File is closed at the end of its scope, before the allocation or an error can longjmp
+        bool opened = false;
+        {
+            File f = SPIFFS.open(arg, "r");
+            if (f)
+            {
+                opened = true;
+                size = f.size();
+            }
+        }
+        if (!opened)
+        {
+            return luaL_error(L, "lge.load_3d_model: no embedded mesh or file named %s", arg);
+        }
+
+        // Left on the stack, collected on error
+        uint8_t *buffer = (uint8_t *)lua_newuserdata(L, size);
+        size_t got = 0;
+        {
+            File f = SPIFFS.open(arg, "r");
+            if (f)
+                got = f.read(buffer, size);
+        }
+        if (got != size)
+        {
+            return luaL_error(L, "lge.load_3d_model: short read on %s", arg);
+        }
+        data = buffer;
+        isFile = true;
+    }
+
+    // Levels of detail are chained, finest first
+    Mesh3D lods[MAX_LODS_3D];
+    int lodCount = 0;
+    const uint8_t *at = (const uint8_t *)data;
+    size_t left = size;
+    for (;;)
+    {
+        MeshView view;
+        const char *error = parseMeshBlob(at, left, view);
+        if (error)
+        {
+            return luaL_error(L, "lge.load_3d_model: %s (level %d)", error, lodCount);
+        }
+
+        Mesh3D &mesh = lods[lodCount];
+        mesh.vertices = view.vertices;
+        mesh.vertCount = view.header->vertexCount;
+        mesh.vertexScale = view.header->vertexScale;
+        mesh.indices8 = view.indices8;
+        mesh.indices16 = view.indices16;
+        mesh.faceCnt = view.header->faceCount;
+        mesh.faceNormals = view.faceNormals;
+        mesh.facePlaneD = view.facePlaneD;
+        mesh.faceSource = lodCount == 0 ? nullptr : view.faceSource;
+        for (int k = 0; k < 3; ++k)
+            mesh.boundCenter[k] = view.header->boundCenter[k];
+        mesh.boundRadius = view.header->boundRadius;
+        mesh.lodRadius = view.header->lodRadius;
+
+        // Instance colors are indexed by the finest level's faces
+        if (lodCount > 0)
+        {
+            size_t finestFaces = lods[0].faceCount();
+            for (size_t f = 0; f < mesh.faceCount(); ++f)
+            {
+                if (!mesh.faceSource || mesh.faceSource[f] >= finestFaces)
+                    return luaL_error(L, "lge.load_3d_model: level %d has no valid face sources", lodCount);
+            }
+        }
+        ++lodCount;
+
+        uint32_t next = view.header->nextOffset;
+        if (next == 0)
+            break;
+        if (lodCount == MAX_LODS_3D)
+            return luaL_error(L, "lge.load_3d_model: more than %d levels of detail", MAX_LODS_3D);
+        at += next;
+        left -= next;
+    }
+    lods[lodCount - 1].lodRadius = 0.0f;
+
+    self->reserve3dModel(L);
+
+    int blobRef = LUA_NOREF;
+    if (isString || isFile)
+    {
+        if (isString)
+            lua_pushvalue(L, 1);
+        blobRef = luaL_ref(L, LUA_REGISTRYINDEX); // the string, or the file buffer on top
+    }
+
+    Model3D model;
+    model.lods.assign(lods, lods + lodCount);
+    model.blobRef = blobRef;
+
+    int modelId = self->add3dModel(std::move(model));
+
+    lua_pushinteger(L, modelId);
+    return 1;
+}
+
+int LuaDriver::lge_create_3d_instance(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    lua_Integer modelId = luaL_checkinteger(L, 1);
+    luaL_checktype(L, 2, LUA_TTABLE); // tri_colors
+
+    int modelIndex = slot3d(self->models3d_, modelId);
+    if (modelIndex < 0)
+    {
+        return luaL_error(L, "lge.create_3d_instance: invalid model id %d", (int)modelId);
+    }
+
+    size_t faceCount = self->models3d_[modelIndex].lods[0].faceCount();
+
+    // Textured faces: u, v in 0..1 for each corner
+    bool textured = !lua_isnoneornil(L, 3);
+    int textureId = 0;
+    if (textured)
+    {
+        textureId = (int)luaL_checkinteger(L, 3);
+        if (textureId <= 0 || textureId > (int)self->textures3d_.size())
+        {
+            return luaL_error(L, "lge.create_3d_instance: invalid texture id %d", textureId);
+        }
+        luaL_checktype(L, 4, LUA_TTABLE); // tri_uvs
+
+        size_t ulen = lua_rawlen(L, 4);
+        if (ulen < faceCount * 6)
+        {
+            return luaL_error(L, "lge.create_3d_instance: got %d texture coordinates for %d faces, need 6 per face",
+                              (int)ulen, (int)faceCount);
+        }
+    }
+
+    size_t clen = lua_rawlen(L, 2);
+    if (clen < faceCount && !textured)
+    {
+        Serial.printf("lge.create_3d_instance: got %u colors for %u faces, padding with white\n",
+                      (unsigned)clen, (unsigned)faceCount);
+    }
+
+    // Filled in place, a recycled slot reuses the storage of the instance destroyed there.
+    // The slot only goes live at the end, a Lua error on the way leaves it free.
+    int slot = self->reserve3dInstance(L);
+    Instance3D &instance = self->instances3d_[slot];
+    instance.modelIndex = modelIndex;
+
+    instance.faceColors565.resize(faceCount);
+
+    for (size_t i = 0; i < faceCount; ++i)
+    {
+        uint16_t color565 = TFT_WHITE;
+
+        if (i < clen)
+        {
+            lua_rawgeti(L, 2, (int)(i + 1));
+            const char *hex = luaL_checkstring(L, -1);
+            lua_pop(L, 1);
+            color565 = self->parseHexColor(hex);
+        }
+
+        instance.faceColors565[i] = color565;
+    }
+
+    // Texture coordinates are kept in texels
+    if (textured)
+    {
+        const Texture3D &texture = self->textures3d_[textureId - 1];
+        const float size[2] = {(float)(1 << texture.widthLog2), (float)(1 << texture.heightLog2)};
+        instance.textureIndex = textureId - 1;
+        instance.faceUV.resize(faceCount * 6);
+        for (size_t i = 0; i < faceCount * 6; ++i)
+        {
+            lua_rawgeti(L, 4, (int)(i + 1));
+            float t = (float)luaL_checknumber(L, -1) * size[i & 1];
+            lua_pop(L, 1);
+            instance.faceUV[i] = std::max(-Rasterizer3D::TEXTURE_UV_LIMIT, std::min(t, Rasterizer3D::TEXTURE_UV_LIMIT));
+        }
+    }
+
+    // Shade table over the unique base colors (instances typically use a handful)
+    std::vector<uint16_t> uniqueColors;
+    instance.facePalette.resize(faceCount);
+    for (size_t i = 0; i < faceCount; ++i)
+    {
+        uint16_t color565 = instance.faceColors565[i];
+        size_t p = 0;
+        while (p < uniqueColors.size() && uniqueColors[p] != color565)
+            ++p;
+        if (p == uniqueColors.size())
+            uniqueColors.push_back(color565);
+        instance.facePalette[i] = (uint16_t)p;
+    }
+
+    instance.shadeTable332.resize(uniqueColors.size() * LIGHT_LEVELS_3D);
+    for (size_t p = 0; p < uniqueColors.size(); ++p)
+    {
+        for (int level = 0; level < LIGHT_LEVELS_3D; ++level)
+        {
+            float brightness = (float)level / (float)(LIGHT_LEVELS_3D - 1);
+            instance.shadeTable332[p * LIGHT_LEVELS_3D + level] = color565To332(scaleColor565(uniqueColors[p], brightness));
+        }
+    }
+
+    self->freeInstances3d_.pop_back();
+    instance.alive = true;
+    self->models3d_[modelIndex].instanceCount++;
+
+    lua_pushinteger(L, handle3d(slot, instance.generation));
+    return 1;
+}
+
+// Returns the slot the next instance will take (the top of freeInstances3d_, growing the pool if
+// it is empty), reset but with the previous instance's vector capacity. It stays free until the
+// caller pops it.
+int LuaDriver::reserve3dInstance(lua_State *L)
+{
+    if (freeInstances3d_.empty())
+    {
+        if (instances3d_.size() >= (1u << HANDLE_SLOT_BITS_3D) - 1)
+            return luaL_error(L, "lge.create_3d_instance: too many instances");
+
+        instances3d_.emplace_back();
+        instances3d_.back().alive = false;
+        freeInstances3d_.push_back((int)instances3d_.size() - 1);
+    }
+
+    int slot = freeInstances3d_.back();
+    reset3dInstance(instances3d_[slot]);
+    return slot;
+}
+
+// Back to a default instance, keeping the slot's generation and every vector's capacity
+void LuaDriver::reset3dInstance(Instance3D &inst)
+{
+    inst.modelIndex = -1;
+    inst.lodLevel = 0;
+    inst.faceColors565.clear();
+    inst.facePalette.clear();
+    inst.shadeTable332.clear();
+    inst.smooth = false;
+    inst.textureIndex = -1;
+    inst.faceUV.clear();
+
+    std::fill(inst.pose, inst.pose + 7, 0.0f);
+    inst.poseGeneration = 0;
+    inst.poseCached = false;
+    inst.cachedScreenXY.clear();
+    inst.cachedCameraZ.clear();
+    inst.cachedShade.clear();
+    inst.cachedUV.clear();
+    inst.cachedFaceB.clear();
+    inst.cachedFaceZ.clear();
+    inst.cachedFaceColor.clear();
+    inst.cachedFaceRamp.clear();
+
+    inst.retained = false;
+    inst.retainedVisible = false;
+    inst.canvasGeneration = 0;
+    inst.alive = false;
+}
+
+// Makes sure freeModels3d_ holds a slot for the next add3dModel, growing the pool if it is empty.
+// Called before the model is built, so that the error doesn't skip its destructor.
+void LuaDriver::reserve3dModel(lua_State *L)
+{
+    if (!freeModels3d_.empty())
+        return;
+
+    if (models3d_.size() >= (1u << HANDLE_SLOT_BITS_3D) - 1)
+        luaL_error(L, "lge: too many 3D models");
+
+    models3d_.emplace_back();
+    models3d_.back().alive = false;
+    freeModels3d_.push_back((int)models3d_.size() - 1);
+}
+
+// Stores a model in the slot taken by reserve3dModel and returns its Lua id
+int LuaDriver::add3dModel(Model3D &&model)
+{
+    size_t slot = (size_t)freeModels3d_.back();
+    freeModels3d_.pop_back();
+
+    uint16_t generation = models3d_[slot].generation;
+    models3d_[slot] = std::move(model);
+    models3d_[slot].generation = generation;
+    models3d_[slot].alive = true;
+    models3d_[slot].instanceCount = 0;
+    return handle3d(slot, generation);
+}
+
+int LuaDriver::lge_destroy_3d_instance(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    int slot = slot3d(self->instances3d_, luaL_checkinteger(L, 1));
+    if (slot < 0)
+    {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+
+    // Storage stays with the slot for the next instance, the id dies with the generation
+    Instance3D &inst = self->instances3d_[slot];
+    inst.alive = false;
+    inst.generation = (inst.generation + 1) & HANDLE_GENERATION_MASK_3D;
+    self->models3d_[inst.modelIndex].instanceCount--;
+    self->freeInstances3d_.push_back(slot);
+
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+int LuaDriver::lge_destroy_3d_model(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    int slot = slot3d(self->models3d_, luaL_checkinteger(L, 1));
+    if (slot < 0 || self->models3d_[slot].instanceCount > 0)
+    {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+
+    // Meshes are large, so unlike instances the memory is released (and a string blob unpinned)
+    Model3D &model = self->models3d_[slot];
+    luaL_unref(L, LUA_REGISTRYINDEX, model.blobRef);
+    uint16_t generation = (model.generation + 1) & HANDLE_GENERATION_MASK_3D;
+    model = Model3D();
+    model.generation = generation;
+    model.alive = false;
+    self->freeModels3d_.push_back(slot);
+
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+int LuaDriver::lge_create_3d_texture(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    int width = (int)luaL_checkinteger(L, 1);
+    int height = (int)luaL_checkinteger(L, 2);
+    size_t len = 0;
+    const char *pixels = luaL_checklstring(L, 3, &len);
+
+    const int maxSide = 1 << MAX_TEXTURE_LOG2_3D;
+    if (width <= 0 || height <= 0 || width > maxSide || height > maxSide ||
+        (width & (width - 1)) != 0 || (height & (height - 1)) != 0)
+    {
+        return luaL_error(L, "lge.create_3d_texture: sides must be powers of two up to %d, got %dx%d",
+                          maxSide, width, height);
+    }
+    if (len < (size_t)width * height)
+    {
+        return luaL_error(L, "lge.create_3d_texture: got %d bytes of pixels for %dx%d",
+                          (int)len, width, height);
+    }
+
+    // Texels are canvas colors, or indices into a palette of hex colors
+    uint8_t lookup[256];
+    for (int i = 0; i < 256; ++i)
+        lookup[i] = (uint8_t)i;
+    if (!lua_isnoneornil(L, 4))
+    {
+        luaL_checktype(L, 4, LUA_TTABLE);
+        size_t plen = lua_rawlen(L, 4);
+        for (int i = 0; i < 256; ++i)
+        {
+            uint16_t color565 = TFT_WHITE;
+            if ((size_t)i < plen)
+            {
+                lua_rawgeti(L, 4, i + 1);
+                color565 = self->parseHexColor(luaL_checkstring(L, -1));
+                lua_pop(L, 1);
+            }
+            lookup[i] = color565To332(color565);
+        }
+    }
+
+    Texture3D texture;
+    while ((1 << texture.widthLog2) < width)
+        ++texture.widthLog2;
+    while ((1 << texture.heightLog2) < height)
+        ++texture.heightLog2;
+    texture.texels.resize((size_t)width * height);
+    for (size_t i = 0; i < texture.texels.size(); ++i)
+        texture.texels[i] = lookup[(uint8_t)pixels[i]];
+
+    // Shared by every lit texture, so built once
+    if (self->textureShade332_.empty())
+    {
+        self->textureShade332_.resize(LIGHT_LEVELS_3D * 256);
+        for (int level = 0; level < LIGHT_LEVELS_3D; ++level)
+        {
+            float brightness = (float)level / (float)(LIGHT_LEVELS_3D - 1);
+            for (int c = 0; c < 256; ++c)
+                self->textureShade332_[level * 256 + c] = color565To332(scaleColor565(color332To565((uint8_t)c), brightness));
+        }
+    }
+
+    self->textures3d_.push_back(std::move(texture));
+    lua_pushinteger(L, (int)self->textures3d_.size()); // 1-based for Lua
+    return 1;
+}
+
+// Grows the scratch vertex buffers and the visible face pool to hold `vertexEnd` vertices and `faceEnd` faces
+void LuaDriver::reserve3dScratch(size_t vertexEnd, size_t faceEnd)
+{
+    if (cameraZ3d_.size() < vertexEnd)
+    {
+        screenXY3d_.resize(vertexEnd * 2);
+        cameraZ3d_.resize(vertexEnd);
+        vertexShade3d_.resize(vertexEnd);
+        vertexUV3d_.resize(vertexEnd * 2);
+    }
+    if (visibleZ_.size() < faceEnd)
+    {
+        visibleZ_.resize(faceEnd);
+        visibleB1_.resize(faceEnd);
+        visibleB2_.resize(faceEnd);
+        visibleB3_.resize(faceEnd);
+        visibleColor_.resize(faceEnd);
+        visibleRamp_.resize(faceEnd);
+        visibleTexture_.resize(faceEnd);
+        visibleSlot_.resize(faceEnd);
+    }
+}
+
+// Appends one posed instance to the shared face pool, replaying its cached transform when the pose
+// is unchanged. Returns true if the instance is visible (faces queued, or a retained instance left
+// on the canvas); `vertexBase` and `visCount` advance past this instance.
+bool LuaDriver::queue3dInstance(int64_t instanceId, float wx, float wy, float wz, float radius,
+                                float ax, float ay, float az, int slot, size_t &vertexBase, int &visCount)
+{
+    int instanceSlot = slot3d(instances3d_, instanceId);
+    if (instanceSlot < 0)
+        return false;
+
+    Instance3D &inst = instances3d_[instanceSlot];
+    if (inst.modelIndex < 0 || inst.modelIndex >= (int)models3d_.size())
+        return false;
+
+    const float pose[7] = {wx, wy, wz, radius, ax, ay, az};
+    bool samePose = inst.poseGeneration == view3dGeneration_ && std::equal(pose, pose + 7, inst.pose);
+
+    if (!samePose)
+    {
+        std::copy(pose, pose + 7, inst.pose);
+        inst.poseGeneration = view3dGeneration_;
+        inst.poseCached = false;
+    }
+    else if (inst.retained && inst.poseCached && inst.canvasGeneration == canvasGeneration_)
+    {
+        // Still on the canvas from the last draw, nothing to do
+        return inst.retainedVisible;
+    }
+
+    inst.canvasGeneration = canvasGeneration_;
 
-        // Store camera-space coords
-        self->tempVertices3d_[tmpBase + 0] = camX;
-        self->tempVertices3d_[tmpBase + 1] = camY;
-        self->tempVertices3d_[tmpBase + 2] = camZ;
+    if (inst.poseCached)
+    {
+        int faceCount = (int)inst.cachedFaceZ.size();
+        inst.retainedVisible = faceCount > 0;
+        if (faceCount == 0)
+            return false;
+        if (visCount + faceCount > MAX_VISIBLE_FACES_3D)
+        {
+            warn3dFaceLimit();
+            return false;
+        }
+
+        size_t vertCount = inst.cachedCameraZ.size();
+        reserve3dScratch(vertexBase + vertCount, visCount + faceCount);
+        std::copy(inst.cachedScreenXY.begin(), inst.cachedScreenXY.end(), screenXY3d_.begin() + vertexBase * 2);
+        std::copy(inst.cachedCameraZ.begin(), inst.cachedCameraZ.end(), cameraZ3d_.begin() + vertexBase);
+        std::copy(inst.cachedShade.begin(), inst.cachedShade.end(), vertexShade3d_.begin() + vertexBase);
+        std::copy(inst.cachedUV.begin(), inst.cachedUV.end(), vertexUV3d_.begin() + vertexBase * 2);
+
+        const Texture3D *texture = inst.textureIndex >= 0 ? &textures3d_[inst.textureIndex] : nullptr;
+        const uint8_t *rampBase = texture ? textureShade332_.data() : inst.shadeTable332.data();
+        int offset = (int)vertexBase;
+        for (int k = 0; k < faceCount; ++k)
+        {
+            visibleZ_[visCount] = inst.cachedFaceZ[k];
+            visibleB1_[visCount] = inst.cachedFaceB[k * 3 + 0] + offset;
+            visibleB2_[visCount] = inst.cachedFaceB[k * 3 + 1] + offset;
+            visibleB3_[visCount] = inst.cachedFaceB[k * 3 + 2] + offset;
+            visibleColor_[visCount] = inst.cachedFaceColor[k];
+            int32_t ramp = inst.cachedFaceRamp[k];
+            visibleRamp_[visCount] = ramp >= 0 ? rampBase + ramp : nullptr;
+            visibleTexture_[visCount] = texture;
+            visibleSlot_[visCount] = (uint16_t)slot;
+            ++visCount;
+        }
 
-        // Store screen-space coords
-        self->tempVertices3d_[tmpBase + 3] = sx;
-        self->tempVertices3d_[tmpBase + 4] = sy;
+        vertexBase += vertCount;
+        return true;
     }
 
-    // 2) Back-face culling + visible face pool
-    int visCount = 0;
+    size_t firstVertex = vertexBase;
+    int firstVisible = visCount;
+    faceLimitHit3d_ = false;
+    int queued = transform3dInstance(inst, wx, wy, wz, radius, ax, ay, az, slot, vertexBase, visCount);
+    inst.retainedVisible = queued > 0;
 
-    for (size_t f = 0; f < faceCount; ++f)
+    // Second draw with the same pose: keep the result, the instance is probably standing still.
+    // Not when faces were dropped at the face limit, a later call may have room for them.
+    if (samePose && !faceLimitHit3d_)
     {
-        int i1 = indices[f * 3 + 0];
-        int i2 = indices[f * 3 + 1];
-        int i3 = indices[f * 3 + 2];
+        inst.cachedScreenXY.assign(screenXY3d_.begin() + firstVertex * 2, screenXY3d_.begin() + vertexBase * 2);
+        inst.cachedCameraZ.assign(cameraZ3d_.begin() + firstVertex, cameraZ3d_.begin() + vertexBase);
+        inst.cachedFaceZ.assign(visibleZ_.begin() + firstVisible, visibleZ_.begin() + visCount);
+        inst.cachedFaceColor.assign(visibleColor_.begin() + firstVisible, visibleColor_.begin() + visCount);
+        if (inst.smooth)
+            inst.cachedShade.assign(vertexShade3d_.begin() + firstVertex, vertexShade3d_.begin() + vertexBase);
+        else
+            inst.cachedShade.clear();
+        if (inst.textureIndex >= 0)
+            inst.cachedUV.assign(vertexUV3d_.begin() + firstVertex * 2, vertexUV3d_.begin() + vertexBase * 2);
+        else
+            inst.cachedUV.clear();
+        inst.cachedFaceB.resize(queued * 3);
+        inst.cachedFaceRamp.resize(queued);
+        const uint8_t *rampBase = inst.textureIndex >= 0 ? textureShade332_.data() : inst.shadeTable332.data();
+        int offset = (int)firstVertex;
+        for (int k = 0; k < queued; ++k)
+        {
+            const uint8_t *ramp = visibleRamp_[firstVisible + k];
+            inst.cachedFaceRamp[k] = ramp ? (int32_t)(ramp - rampBase) : -1;
+            inst.cachedFaceB[k * 3 + 0] = visibleB1_[firstVisible + k] - offset;
+            inst.cachedFaceB[k * 3 + 1] = visibleB2_[firstVisible + k] - offset;
+            inst.cachedFaceB[k * 3 + 2] = visibleB3_[firstVisible + k] - offset;
+        }
+        inst.poseCached = true;
+    }
+
+    return queued > 0;
+}
+
+// Transforms one posed instance and appends its visible faces to the shared face pool.
+// Returns the number of faces queued; `vertexBase` and `visCount` advance past this instance.
+int LuaDriver::transform3dInstance(Instance3D &inst, float wx, float wy, float wz, float radius,
+                                   float ax, float ay, float az, int slot, size_t &vertexBase, int &visCount)
+{
+    const Model3D &model = models3d_[inst.modelIndex];
+
+    if (model.lods[0].vertexCount() == 0 || model.lods[0].faceCount() == 0)
+        return 0;
+
+    const float fov = fov3d_;
+    const float *view = view3d_;
 
-        int b1 = i1 * 6;
-        int b2 = i2 * 6;
-        int b3 = i3 * 6;
+    // Rotation matrix for Rx, then Ry, then Rz (row-major), also used to light the face normals
+    float rot[9];
+    buildRotation3d(ax, ay, az, rot);
 
-        float sx1 = self->tempVertices3d_[b1 + 3];
-        float sy1 = self->tempVertices3d_[b1 + 4];
-        float sz1 = self->tempVertices3d_[b1 + 2];
+    // Model-to-camera transform [A | t]: view rotation times model rotation, instance position seen from the eye
+    float m[12];
+    for (int r = 0; r < 3; ++r)
+    {
+        const float *v = &view[r * 4];
+        for (int c = 0; c < 3; ++c)
+            m[r * 4 + c] = v[0] * rot[c] + v[1] * rot[3 + c] + v[2] * rot[6 + c];
+        m[r * 4 + 3] = v[0] * wx + v[1] * wy + v[2] * wz + v[3];
+    }
 
-        float sx2 = self->tempVertices3d_[b2 + 3];
-        float sy2 = self->tempVertices3d_[b2 + 4];
-        float sz2 = self->tempVertices3d_[b2 + 2];
+    // Approximate scale so that projected radius ~ 'radius' at depth ~ wz, as seen from the default
+    // camera. It only depends on the world position, so moving the view doesn't resize instances.
+    // visual_radius ≈ scale * (fov / wz)  =>  scale ≈ radius * (wz / fov)
+    float depth = wz;
+    if (depth < 1.0f)
+        depth = 1.0f; // Prevent a zero or negative scale
+    float baseScale = radius * (depth / fov);
 
-        float sx3 = self->tempVertices3d_[b3 + 3];
-        float sy3 = self->tempVertices3d_[b3 + 4];
-        float sz3 = self->tempVertices3d_[b3 + 2];
+    // Projection center = center of sprite
+    float centerX = spr_->width() * 0.5f;
+    float centerY = spr_->height() * 0.5f;
 
-        // screen-space 2D cross product for back-face culling
-        float normal_z = (sx2 - sx1) * (sy3 - sy1) - (sy2 - sy1) * (sx3 - sx1);
-        if (normal_z >= 0.0f)
+    // 0) Whole-instance rejection: bounding sphere against the near plane and the four planes
+    // through the camera and the screen edges (sx = 0, sx = width, sy = 0, sy = height).
+    // The same sphere's projected radius picks the level of detail.
+    float cameraExtent; // bound on the absolute camera coordinates of every vertex
+    {
+        const float *c = model.lods[0].boundCenter;
+        float cx = (m[0] * c[0] + m[1] * c[1] + m[2] * c[2]) * baseScale + m[3];
+        float cy = (m[4] * c[0] + m[5] * c[1] + m[6] * c[2]) * baseScale + m[7];
+        float cz = (m[8] * c[0] + m[9] * c[1] + m[10] * c[2]) * baseScale + m[11];
+        float r = model.lods[0].boundRadius * std::fabs(baseScale);
+        cameraExtent = std::max({std::fabs(cx), std::fabs(cy), std::fabs(cz)}) + r;
+
+        if (cz + r <= NEAR_PLANE_3D)
+            return 0;
+
+        float rightX = spr_->width() - centerX;
+        float bottomY = spr_->height() - centerY;
+        if (fov * cx + centerX * cz < -r * std::sqrt(fov * fov + centerX * centerX) ||
+            rightX * cz - fov * cx < -r * std::sqrt(fov * fov + rightX * rightX) ||
+            fov * cy + centerY * cz < -r * std::sqrt(fov * fov + centerY * centerY) ||
+            bottomY * cz - fov * cy < -r * std::sqrt(fov * fov + bottomY * bottomY))
+            return 0;
+
+        // Coarser while below the current level's switch radius, finer while above the previous one's,
+        // with a band around each switch radius so an instance at the boundary doesn't flicker
+        // Texture coordinates belong to the finest level's corners, so textured instances always draw it
+        int lodCount = (int)model.lods.size();
+        if (lodCount > 1 && inst.textureIndex < 0)
         {
+            float projected = (cz > NEAR_PLANE_3D) ? r * fov / cz : r * fov / NEAR_PLANE_3D;
+            int level = std::min(inst.lodLevel, lodCount - 1);
+            while (level + 1 < lodCount && projected < model.lods[level].lodRadius * (1.0f - LOD_HYSTERESIS_3D))
+                ++level;
+            while (level > 0 && projected > model.lods[level - 1].lodRadius * (1.0f + LOD_HYSTERESIS_3D))
+                --level;
+            inst.lodLevel = level;
+        }
+    }
+
+    const Mesh3D &mesh = model.lods[inst.lodLevel];
+    const int16_t *srcVerts = mesh.vertices;
+    size_t vertCount = mesh.vertexCount();
+    size_t faceCount = mesh.faceCount();
+
+    // The depth sort indexes faces with 16 bits
+    if (visCount + faceCount > MAX_VISIBLE_FACES_3D)
+    {
+        warn3dFaceLimit();
+        return 0;
+    }
+
+    // Ensure scratch buffers are large enough, this instance's vertices follow those already queued
+    reserve3dScratch(vertexBase + vertCount, visCount + faceCount);
+    frontFaces3d_.resize(faceCount);
+    touchedVertices3d_.assign((vertCount + 31) / 32, 0);
+
+    // 1) Back-face culling in model space, before any vertex is transformed.
+    // The eye in model space is -A^T * t / scale; the scale is folded into the
+    // plane offset instead so that radius 0 or negative needs no division:
+    // front face <=> n . (-A^T t) + scale * d > 0
+    float camMX = -(m[0] * m[3] + m[4] * m[7] + m[8] * m[11]);
+    float camMY = -(m[1] * m[3] + m[5] * m[7] + m[9] * m[11]);
+    float camMZ = -(m[2] * m[3] + m[6] * m[7] + m[10] * m[11]);
+
+    const int16_t *normals = mesh.faceNormals;
+    const float *planeD = mesh.facePlaneD;
+    uint32_t *touched = touchedVertices3d_.data();
+    int frontCount = 0;
+
+    for (size_t f = 0; f < faceCount; ++f)
+    {
+        const int16_t *n = &normals[f * 3];
+        if (n[0] * camMX + n[1] * camMY + n[2] * camMZ + baseScale * planeD[f] <= 0.0f)
             continue; // back face
+
+        frontFaces3d_[frontCount++] = (int)f;
+        for (int k = 0; k < 3; ++k)
+        {
+            int vi = mesh.index(f * 3 + k);
+            touched[vi >> 5] |= 1u << (vi & 31);
         }
+    }
 
-        float avgZ = (sz1 + sz2 + sz3) * (1.0f / 3.0f);
+    if (frontCount == 0)
+        return 0;
 
-        uint16_t col = TFT_WHITE;
-        if (f < inst.faceColors565.size())
-            col = inst.faceColors565[f];
+    // Fold the scale and the quantization step into the rotation, every vertex then costs a single 3x4 multiply
+    float vertexScale = baseScale * mesh.vertexScale;
+    bool fixedPoint = model.fixedPoint &&
+                      fixedTransform3d_.setup(m, vertexScale, cameraExtent, fov, centerX, centerY, NEAR_PLANE_3D);
+    for (int r = 0; r < 3; ++r)
+    {
+        m[r * 4 + 0] *= vertexScale;
+        m[r * 4 + 1] *= vertexScale;
+        m[r * 4 + 2] *= vertexScale;
+    }
+
+    // 2) Transform vertices referenced by front faces: model -> camera -> screen
+    int16_t *screenXY = &screenXY3d_[vertexBase * 2];
+    float *cameraZ = &cameraZ3d_[vertexBase];
+    uint16_t *shade = &vertexShade3d_[vertexBase];
+    bool smooth = inst.smooth && lightEnabled_ && mesh.vertexNormals && inst.textureIndex < 0;
+    const Texture3D *texture = inst.textureIndex >= 0 ? &textures3d_[inst.textureIndex] : nullptr;
+    for (size_t i = 0; i < vertCount; ++i)
+    {
+        if (!(touched[i >> 5] & (1u << (i & 31))))
+            continue;
 
-        uint16_t finalCol = col;
+        const int16_t *v = &srcVerts[i * 3];
 
-        if (self->lightEnabled_)
+        if (smooth)
         {
-            // Use camera-space positions directly for face normal
-            float cx1 = self->tempVertices3d_[b1 + 0];
-            float cy1 = self->tempVertices3d_[b1 + 1];
-            float cz1 = self->tempVertices3d_[b1 + 2];
-
-            float cx2 = self->tempVertices3d_[b2 + 0];
-            float cy2 = self->tempVertices3d_[b2 + 1];
-            float cz2 = self->tempVertices3d_[b2 + 2];
-
-            float cx3 = self->tempVertices3d_[b3 + 0];
-            float cy3 = self->tempVertices3d_[b3 + 1];
-            float cz3 = self->tempVertices3d_[b3 + 2];
-
-            // e1 = p2 - p1, e2 = p3 - p1
-            float e1x = cx2 - cx1;
-            float e1y = cy2 - cy1;
-            float e1z = cz2 - cz1;
-
-            float e2x = cx3 - cx1;
-            float e2y = cy3 - cy1;
-            float e2z = cz3 - cz1;
-
-            // normal = e1 x e2
-            float nx = e1y * e2z - e1z * e2y;
-            float ny = e1z * e2x - e1x * e2z;
-            float nz = e1x * e2y - e1y * e2x;
-
-            float nlen = std::sqrt(nx * nx + ny * ny + nz * nz);
-            float ndotl = 0.0f;
-            if (nlen > 1e-4f)
-            {
-                nx /= nlen;
-                ny /= nlen;
-                nz /= nlen;
+            // Light level at the vertex in 8.8, the rasterizer interpolates it across the face
+            const int16_t *n = &mesh.vertexNormals[i * 3];
+            float nx = rot[0] * n[0] + rot[1] * n[1] + rot[2] * n[2];
+            float ny = rot[3] * n[0] + rot[4] * n[1] + rot[5] * n[2];
+            float nz = rot[6] * n[0] + rot[7] * n[1] + rot[8] * n[2];
+            float ndotl = (nx * lightDirX_ + ny * lightDirY_ + nz * lightDirZ_) * (1.0f / NORMAL_ONE_3D);
+            if (ndotl < 0.0f)
+                ndotl = 0.0f;
+
+            float level = (lightAmbient_ + lightDiffuse_ * ndotl) * (LIGHT_LEVELS_3D - 1) + 0.5f;
+            level = std::max(0.0f, std::min(level, (float)LIGHT_LEVELS_3D - 1.0f / 256.0f));
+            shade[i] = (uint16_t)(level * 256.0f);
+        }
+
+        if (fixedPoint)
+        {
+            if (!fixedTransform3d_.transform(v, cameraZ[i], &screenXY[i * 2]))
+                screenXY[i * 2] = OFFSCREEN_3D;
+            continue;
+        }
+
+        float camX = m[0] * v[0] + m[1] * v[1] + m[2] * v[2] + m[3];
+        float camY = m[4] * v[0] + m[5] * v[1] + m[6] * v[2] + m[7];
+        float camZ = m[8] * v[0] + m[9] * v[1] + m[10] * v[2] + m[11]; // looking along +Z
+        cameraZ[i] = camZ;
 
-                ndotl = nx * self->lightDirX_ +
-                        ny * self->lightDirY_ +
-                        nz * self->lightDirZ_;
+        // Screen position in 12.4, vertices behind the near plane or beyond the guard band are only reached through clip3dFace
+        screenXY[i * 2] = OFFSCREEN_3D;
+        if (camZ >= NEAR_PLANE_3D)
+        {
+            float z_factor = fov / camZ;
+            float sx = camX * z_factor + centerX;
+            float sy = camY * z_factor + centerY;
+            if (Rasterizer3D::inGuardBand(sx, sy))
+            {
+                screenXY[i * 2 + 0] = (int16_t)Rasterizer3D::toSubpixel(sx);
+                screenXY[i * 2 + 1] = (int16_t)Rasterizer3D::toSubpixel(sy);
             }
+        }
+    }
+
+    // 3) Visible face pool: depth and shaded color. Clipped faces add their new vertices after this instance's own.
+    int firstVisible = visCount;
+    size_t vertexEnd = vertexBase + vertCount;
+
+    for (int k = 0; k < frontCount; ++k)
+    {
+        size_t f = (size_t)frontFaces3d_[k];
+
+        int i1 = mesh.index(f * 3 + 0);
+        int i2 = mesh.index(f * 3 + 1);
+        int i3 = mesh.index(f * 3 + 2);
+
+        // Colors belong to the finest level's faces
+        size_t cf = mesh.faceSource ? mesh.faceSource[f] : f;
+
+        uint16_t col = TFT_WHITE;
+        if (cf < inst.faceColors565.size())
+            col = inst.faceColors565[cf];
+
+        FaceStyle3D style = {color565To332(col), nullptr, texture};
+
+        // Smooth faces draw from their palette's shade ramp, flat faces take one level from the face normal
+        if (smooth && cf < inst.facePalette.size())
+            style.ramp = &inst.shadeTable332[inst.facePalette[cf] * LIGHT_LEVELS_3D];
+        else if (lightEnabled_)
+        {
+            // Precomputed unit normal rotated into world space, where the light lives (uniform scale keeps it unit length)
+            const int16_t *n = &normals[f * 3];
+            float nx = rot[0] * n[0] + rot[1] * n[1] + rot[2] * n[2];
+            float ny = rot[3] * n[0] + rot[4] * n[1] + rot[5] * n[2];
+            float nz = rot[6] * n[0] + rot[7] * n[1] + rot[8] * n[2];
+
+            float ndotl = (nx * lightDirX_ +
+                           ny * lightDirY_ +
+                           nz * lightDirZ_) *
+                          (1.0f / NORMAL_ONE_3D);
 
             if (ndotl < 0.0f)
                 ndotl = 0.0f; // Lambert – no negative light
 
-            float brightness = self->lightAmbient_ + self->lightDiffuse_ * ndotl;
-            if (brightness > 1.0f)
-                brightness = 1.0f;
-            if (brightness < 0.0f)
-                brightness = 0.0f;
+            float brightness = lightAmbient_ + lightDiffuse_ * ndotl;
+            int level = (int)(brightness * (LIGHT_LEVELS_3D - 1) + 0.5f);
+            if (level > LIGHT_LEVELS_3D - 1)
+                level = LIGHT_LEVELS_3D - 1;
+            if (level < 0)
+                level = 0;
+
+            if (texture)
+                style.ramp = &textureShade332_[level * 256];
+            else if (cf < inst.facePalette.size())
+                style.color = inst.shadeTable332[inst.facePalette[cf] * LIGHT_LEVELS_3D + level];
+            else
+                style.color = color565To332(scaleColor565(col, (float)level / (float)(LIGHT_LEVELS_3D - 1)));
+        }
+
+        if (!texture && screenXY[i1 * 2] != OFFSCREEN_3D && screenXY[i2 * 2] != OFFSCREEN_3D &&
+            screenXY[i3 * 2] != OFFSCREEN_3D)
+        {
+            float avgZ = (cameraZ[i1] + cameraZ[i2] + cameraZ[i3]) * (1.0f / 3.0f);
+            int b = (int)vertexBase;
+            push3dFace(avgZ, b + i1, b + i2, b + i3, style, slot, visCount);
+            continue;
+        }
 
-            finalCol = scaleColor565(col, brightness);
+        // Rare for colored faces, so camera x and y are recomputed here rather than kept for every vertex.
+        // Textured faces always come here: their corners carry texture coordinates, so they get vertices of their own.
+        float corners[3][CORNER_ATTRS_3D];
+        const int cornerIndex[3] = {i1, i2, i3};
+        for (int c = 0; c < 3; ++c)
+        {
+            int vi = cornerIndex[c];
+            const int16_t *v = &srcVerts[vi * 3];
+            corners[c][0] = m[0] * v[0] + m[1] * v[1] + m[2] * v[2] + m[3];
+            corners[c][1] = m[4] * v[0] + m[5] * v[1] + m[6] * v[2] + m[7];
+            corners[c][2] = cameraZ[vi];
+            corners[c][3] = smooth ? shade[vi] : 0.0f;
+            corners[c][4] = texture ? inst.faceUV[cf * 6 + c * 2 + 0] : 0.0f;
+            corners[c][5] = texture ? inst.faceUV[cf * 6 + c * 2 + 1] : 0.0f;
         }
+        if (texture)
+            subdivide3dFace(corners, style, TEXTURE_SUBDIVIDE_DEPTH_3D, slot, vertexEnd, visCount);
+        else
+            clip3dFace(corners, style, slot, vertexEnd, visCount);
+
+        // Clipping may have grown the scratch buffers
+        screenXY = &screenXY3d_[vertexBase * 2];
+        cameraZ = &cameraZ3d_[vertexBase];
+        shade = &vertexShade3d_[vertexBase];
+    }
+
+    vertexBase = vertexEnd;
+    return visCount - firstVisible;
+}
+
+// Faces past MAX_VISIBLE_FACES_3D are dropped. Reports it once per canvas clear, so a scene over the
+// limit doesn't flood the serial port every frame.
+void LuaDriver::warn3dFaceLimit()
+{
+    faceLimitHit3d_ = true;
+    if (faceLimitWarned3d_ && faceLimitWarnedGeneration3d_ == canvasGeneration_)
+        return;
 
-        self->visibleZ_[visCount] = avgZ;
-        self->visibleB1_[visCount] = b1;
-        self->visibleB2_[visCount] = b2;
-        self->visibleB3_[visCount] = b3;
-        self->visibleColor_[visCount] = finalCol;
-        ++visCount;
+    faceLimitWarned3d_ = true;
+    faceLimitWarnedGeneration3d_ = canvasGeneration_;
+    Serial.printf("lge: more than %d 3D faces in one draw call (the depth sort indexes them with 16 bits), "
+                  "dropping the rest\n",
+                  MAX_VISIBLE_FACES_3D);
+}
+
+// Appends a triangle to the visible face pool, growing it when clipping produced more faces than reserved
+void LuaDriver::push3dFace(float avgZ, int b1, int b2, int b3, const FaceStyle3D &style, int slot, int &visCount)
+{
+    // The depth sort indexes faces with 16 bits
+    if (visCount >= MAX_VISIBLE_FACES_3D)
+    {
+        warn3dFaceLimit();
+        return;
     }
 
-    // 3) Sort visible faces by Z (descending) – insertion sort (few faces, cheap)
-    for (int i = 1; i < visCount; ++i)
+    reserve3dScratch(0, visCount + 1);
+    visibleZ_[visCount] = avgZ;
+    visibleB1_[visCount] = b1;
+    visibleB2_[visCount] = b2;
+    visibleB3_[visCount] = b3;
+    visibleColor_[visCount] = style.color;
+    visibleRamp_[visCount] = style.ramp;
+    visibleTexture_[visCount] = style.texture;
+    visibleSlot_[visCount] = (uint16_t)slot;
+    ++visCount;
+}
+
+// One Sutherland-Hodgman step: keeps the part of a convex polygon where sign * (p[axis] - limit) >= 0.
+// Every attribute is interpolated linearly, which is exact for camera-space positions and for
+// (screen x, screen y, 1/z); the rest (shade, texture coordinates) follow along. A convex polygon gains
+// at most one vertex.
+template <int N>
+static int clipPolygon3d(const float in[][N], int count, float out[][N], int axis, float limit, float sign)
+{
+    int outCount = 0;
+    for (int i = 0; i < count; ++i)
     {
-        float zkey = self->visibleZ_[i];
-        int k_b1 = self->visibleB1_[i];
-        int k_b2 = self->visibleB2_[i];
-        int k_b3 = self->visibleB3_[i];
-        uint16_t k_color = self->visibleColor_[i];
+        const float *a = in[i];
+        const float *b = in[(i + 1) % count];
+        float da = sign * (a[axis] - limit);
+        float db = sign * (b[axis] - limit);
 
-        int j = i - 1;
-        while (j >= 0 && self->visibleZ_[j] < zkey)
+        if (da >= 0.0f)
         {
-            self->visibleZ_[j + 1] = self->visibleZ_[j];
-            self->visibleB1_[j + 1] = self->visibleB1_[j];
-            self->visibleB2_[j + 1] = self->visibleB2_[j];
-            self->visibleB3_[j + 1] = self->visibleB3_[j];
-            self->visibleColor_[j + 1] = self->visibleColor_[j];
-            --j;
+            for (int c = 0; c < N; ++c)
+                out[outCount][c] = a[c];
+            ++outCount;
+        }
+        if ((da >= 0.0f) != (db >= 0.0f))
+        {
+            float t = da / (da - db);
+            for (int c = 0; c < N; ++c)
+                out[outCount][c] = a[c] + (b[c] - a[c]) * t;
+            out[outCount][axis] = limit; // exactly on the plane
+            ++outCount;
         }
-        self->visibleZ_[j + 1] = zkey;
-        self->visibleB1_[j + 1] = k_b1;
-        self->visibleB2_[j + 1] = k_b2;
-        self->visibleB3_[j + 1] = k_b3;
-        self->visibleColor_[j + 1] = k_color;
     }
+    return outCount;
+}
 
-    // 4) Draw visible faces
-    int dirtyRectMinX = self->spr_->width();
-    int dirtyRectMinY = self->spr_->height();
-    int dirtyRectMaxX = 0;
-    int dirtyRectMaxY = 0;
-    for (int i = 0; i < visCount; ++i)
+// Clips a face that crosses the near plane or leaves the rasterizer guard band and queues what remains
+// as a triangle fan. `corners` are in camera space, followed by their other attributes (CORNER_ATTRS_3D),
+// new vertices are appended at `vertexEnd`.
+void LuaDriver::clip3dFace(const float corners[3][CORNER_ATTRS_3D], const FaceStyle3D &style, int slot,
+                           size_t &vertexEnd, int &visCount)
+{
+    // 3 vertices, +1 for the near plane, +1 for each guard band edge
+    float polyA[8][CORNER_ATTRS_3D];
+    float polyB[8][CORNER_ATTRS_3D];
+
+    for (int k = 0; k < 3; ++k)
     {
-        int b1 = self->visibleB1_[i];
-        int b2 = self->visibleB2_[i];
-        int b3 = self->visibleB3_[i];
+        const float *v = corners[k];
+        if (!std::isfinite(v[0]) || !std::isfinite(v[1]) || !std::isfinite(v[2]))
+            return;
+        std::copy(v, v + CORNER_ATTRS_3D, polyA[k]);
+    }
+
+    // Near plane, in camera space
+    int count = clipPolygon3d(polyA, 3, polyB, 2, NEAR_PLANE_3D, 1.0f);
+    if (count < 3)
+        return;
 
-        int x0 = (int)self->tempVertices3d_[b1 + 3];
-        int y0 = (int)self->tempVertices3d_[b1 + 4];
-        int x1 = (int)self->tempVertices3d_[b2 + 3];
-        int y1 = (int)self->tempVertices3d_[b2 + 4];
-        int x2 = (int)self->tempVertices3d_[b3 + 3];
-        int y2 = (int)self->tempVertices3d_[b3 + 4];
+    // Project to (screen x, screen y, 1/z), all linear in screen space
+    const float fov = fov3d_;
+    float centerX = spr_->width() * 0.5f;
+    float centerY = spr_->height() * 0.5f;
+    for (int k = 0; k < count; ++k)
+    {
+        float w = 1.0f / polyB[k][2];
+        polyB[k][0] = polyB[k][0] * fov * w + centerX;
+        polyB[k][1] = polyB[k][1] * fov * w + centerY;
+        polyB[k][2] = w;
+    }
 
-        uint16_t color = self->visibleColor_[i];
+    // Guard band, in screen space
+    const float band = Rasterizer3D::GUARD_BAND - 1.0f;
+    count = clipPolygon3d(polyB, count, polyA, 0, -band, 1.0f);
+    count = clipPolygon3d(polyA, count, polyB, 0, band, -1.0f);
+    count = clipPolygon3d(polyB, count, polyA, 1, -band, 1.0f);
+    count = clipPolygon3d(polyA, count, polyB, 1, band, -1.0f);
+    if (count < 3)
+        return;
 
-        self->spr_->fillTriangle(x0, y0, x1, y1, x2, y2, color);
+    // Append the clipped vertices, every one lies within the guard band now
+    size_t first = vertexEnd;
+    vertexEnd += count;
+    reserve3dScratch(vertexEnd, 0);
+    for (int k = 0; k < count; ++k)
+    {
+        screenXY3d_[(first + k) * 2 + 0] = (int16_t)Rasterizer3D::toSubpixel(polyB[k][0]);
+        screenXY3d_[(first + k) * 2 + 1] = (int16_t)Rasterizer3D::toSubpixel(polyB[k][1]);
+        cameraZ3d_[first + k] = 1.0f / polyB[k][2];
+        vertexShade3d_[first + k] = (uint16_t)(polyB[k][3] + 0.5f);
+        vertexUV3d_[(first + k) * 2 + 0] = (int32_t)(polyB[k][4] * 65536.0f);
+        vertexUV3d_[(first + k) * 2 + 1] = (int32_t)(polyB[k][5] * 65536.0f);
+    }
+
+    int base = (int)first;
+    for (int k = 1; k + 1 < count; ++k)
+    {
+        int c1 = base + k;
+        int c2 = base + k + 1;
+        float avgZ = (cameraZ3d_[base] + cameraZ3d_[c1] + cameraZ3d_[c2]) * (1.0f / 3.0f);
+        push3dFace(avgZ, base, c1, c2, style, slot, visCount);
+    }
+}
+
+// Splits a textured face at its edge midpoints into four, in camera space where the midpoints' texture
+// coordinates are exact, until the pieces are short enough on screen for the rasterizer's affine mapping
+void LuaDriver::subdivide3dFace(const float corners[3][CORNER_ATTRS_3D], const FaceStyle3D &style, int depth, int slot,
+                                size_t &vertexEnd, int &visCount)
+{
+    if (corners[0][2] < NEAR_PLANE_3D && corners[1][2] < NEAR_PLANE_3D && corners[2][2] < NEAR_PLANE_3D)
+        return; // entirely behind the near plane
+
+    bool split = depth > 0;
+    if (split && corners[0][2] >= NEAR_PLANE_3D && corners[1][2] >= NEAR_PLANE_3D && corners[2][2] >= NEAR_PLANE_3D)
+    {
+        // Longest edge on screen; pieces crossing the near plane keep splitting
+        float sx[3], sy[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            float w = fov3d_ / corners[k][2];
+            sx[k] = corners[k][0] * w;
+            sy[k] = corners[k][1] * w;
+        }
+        float longest = 0.0f;
+        for (int k = 0; k < 3; ++k)
+        {
+            int j = (k + 1) % 3;
+            longest = std::max({longest, std::fabs(sx[j] - sx[k]), std::fabs(sy[j] - sy[k])});
+        }
+        split = longest > TEXTURE_SUBDIVIDE_3D;
+    }
+
+    if (!split)
+    {
+        clip3dFace(corners, style, slot, vertexEnd, visCount);
+        return;
+    }
+
+    // mid[k] halves the edge from corner k to corner k + 1
+    float mid[3][CORNER_ATTRS_3D];
+    for (int k = 0; k < 3; ++k)
+        for (int a = 0; a < CORNER_ATTRS_3D; ++a)
+            mid[k][a] = (corners[k][a] + corners[(k + 1) % 3][a]) * 0.5f;
+
+    // Three corner pieces and the middle one, all wound like the original
+    const float *pieces[4][3] = {{corners[0], mid[0], mid[2]},
+                                 {mid[0], corners[1], mid[1]},
+                                 {mid[2], mid[1], corners[2]},
+                                 {mid[0], mid[1], mid[2]}};
+    for (int p = 0; p < 4; ++p)
+    {
+        float piece[3][CORNER_ATTRS_3D];
+        for (int k = 0; k < 3; ++k)
+            std::copy(pieces[p][k], pieces[p][k] + CORNER_ATTRS_3D, piece[k]);
+        subdivide3dFace(piece, style, depth - 1, slot, vertexEnd, visCount);
+    }
+}
+
+// Sorts the shared face pool back to front, draws it and marks one dirty region per queued instance
+void LuaDriver::draw3dFaces(int visCount, int slotCount)
+{
+    if (depthBuffer3d_)
+    {
+        draw3dFacesDepthTested(visCount);
+        return;
+    }
+
+    // 4) Sort visible faces by Z (descending) – radix sort on quantized keys, faces are drawn through the index order
+    const uint16_t *order = depthSorter3d_.sortDescending(visibleZ_.data(), visCount);
+
+    // 5) Draw visible faces straight into the canvas, growing the bounding box of the instance each face belongs to
+    rasterizer3d_.setTarget((uint8_t *)spr_->getPointer(), spr_->width(), spr_->height());
+
+    batchBounds3d_.resize(slotCount * 4);
+    for (int slot = 0; slot < slotCount; ++slot)
+    {
+        batchBounds3d_[slot * 4 + 0] = spr_->width();
+        batchBounds3d_[slot * 4 + 1] = spr_->height();
+        batchBounds3d_[slot * 4 + 2] = 0;
+        batchBounds3d_[slot * 4 + 3] = 0;
+    }
+
+    for (int n = 0; n < visCount; ++n)
+    {
+        int i = order[n];
+        int b1 = visibleB1_[i];
+        int b2 = visibleB2_[i];
+        int b3 = visibleB3_[i];
+
+        const int16_t *s1 = &screenXY3d_[b1 * 2];
+        const int16_t *s2 = &screenXY3d_[b2 * 2];
+        const int16_t *s3 = &screenXY3d_[b3 * 2];
+
+        // Faces were clipped to the guard band when queued
+        if (const Texture3D *texture = visibleTexture_[i])
+        {
+            const int32_t uv[6] = {vertexUV3d_[b1 * 2], vertexUV3d_[b1 * 2 + 1], vertexUV3d_[b2 * 2],
+                                   vertexUV3d_[b2 * 2 + 1], vertexUV3d_[b3 * 2], vertexUV3d_[b3 * 2 + 1]};
+            rasterizer3d_.fillTriangleTextured(s1[0], s1[1], s2[0], s2[1], s3[0], s3[1], uv, texture->texels.data(),
+                                               texture->widthLog2, texture->heightLog2, visibleRamp_[i]);
+        }
+        else if (visibleRamp_[i])
+            rasterizer3d_.fillTriangleShaded(s1[0], s1[1], s2[0], s2[1], s3[0], s3[1],
+                                             vertexShade3d_[b1], vertexShade3d_[b2], vertexShade3d_[b3],
+                                             visibleRamp_[i]);
+        else
+            rasterizer3d_.fillTriangleSubpixel(s1[0], s1[1], s2[0], s2[1], s3[0], s3[1], visibleColor_[i]);
+
+        int x0 = s1[0] >> 4;
+        int y0 = s1[1] >> 4;
+        int x1 = s2[0] >> 4;
+        int y1 = s2[1] >> 4;
+        int x2 = s3[0] >> 4;
+        int y2 = s3[1] >> 4;
 
         // Mark dirty region for partial update
-        int min_x = std::min({x0, x1, x2});
-        int max_x = std::max({x0, x1, x2});
-        int min_y = std::min({y0, y1, y2});
-        int max_y = std::max({y0, y1, y2});
-        if (min_x < dirtyRectMinX)
-            dirtyRectMinX = min_x;
-        if (min_y < dirtyRectMinY)
-            dirtyRectMinY = min_y;
-        if (max_x > dirtyRectMaxX)
-            dirtyRectMaxX = max_x;
-        if (max_y > dirtyRectMaxY)
-            dirtyRectMaxY = max_y;
+        int *bounds = &batchBounds3d_[visibleSlot_[i] * 4];
+        bounds[0] = std::min({bounds[0], x0, x1, x2});
+        bounds[1] = std::min({bounds[1], y0, y1, y2});
+        bounds[2] = std::max({bounds[2], x0, x1, x2});
+        bounds[3] = std::max({bounds[3], y0, y1, y2});
     }
 
-    self->addDirtyRegion(dirtyRectMinX, dirtyRectMinY, dirtyRectMaxX - dirtyRectMinX + 1, dirtyRectMaxY - dirtyRectMinY + 1);
+    for (int slot = 0; slot < slotCount; ++slot)
+    {
+        const int *bounds = &batchBounds3d_[slot * 4];
+        if (bounds[2] >= bounds[0] && bounds[3] >= bounds[1])
+            addDirtyRegion(bounds[0], bounds[1], bounds[2] - bounds[0] + 1, bounds[3] - bounds[1] + 1);
+    }
+}
+
+
+// Depth-tested alternative to the painter's path: no sort, faces are binned into screen tiles
+// and resolved per pixel. Dirty regions are the tiles that actually received pixels.
+void LuaDriver::draw3dFacesDepthTested(int visCount)
+{
+    int width = spr_->width();
+    int height = spr_->height();
+    tileRenderer3d_.begin(width, height);
+
+    for (int i = 0; i < visCount; ++i)
+    {
+        int b1 = visibleB1_[i];
+        int b2 = visibleB2_[i];
+        int b3 = visibleB3_[i];
+        const int16_t *s1 = &screenXY3d_[b1 * 2];
+        const int16_t *s2 = &screenXY3d_[b2 * 2];
+        const int16_t *s3 = &screenXY3d_[b3 * 2];
+
+        // Faces were clipped to the guard band when queued
+        if (const Texture3D *texture = visibleTexture_[i])
+        {
+            const int32_t uv[6] = {vertexUV3d_[b1 * 2], vertexUV3d_[b1 * 2 + 1], vertexUV3d_[b2 * 2],
+                                   vertexUV3d_[b2 * 2 + 1], vertexUV3d_[b3 * 2], vertexUV3d_[b3 * 2 + 1]};
+            tileRenderer3d_.addTriangleTextured(s1[0], s1[1], cameraZ3d_[b1], s2[0], s2[1], cameraZ3d_[b2],
+                                                s3[0], s3[1], cameraZ3d_[b3], uv, texture->texels.data(),
+                                                texture->widthLog2, texture->heightLog2, visibleRamp_[i]);
+            continue;
+        }
+        tileRenderer3d_.addTriangleSubpixel(s1[0], s1[1], cameraZ3d_[b1], s2[0], s2[1], cameraZ3d_[b2],
+                                            s3[0], s3[1], cameraZ3d_[b3], visibleColor_[i], visibleRamp_[i],
+                                            vertexShade3d_[b1], vertexShade3d_[b2], vertexShade3d_[b3]);
+    }
+
+    touchedTiles3d_.clear();
+    tileRenderer3d_.render((uint8_t *)spr_->getPointer(), touchedTiles3d_);
+
+    int tilesX = tileRenderer3d_.tilesX();
+    for (uint16_t tile : touchedTiles3d_)
+    {
+        addDirtyRegion((tile % tilesX) * TILE_SIZE, (tile / tilesX) * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+    }
+}
+
+int LuaDriver::lge_set_3d_depth_buffer(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    self->depthBuffer3d_ = lua_toboolean(L, 1);
+    return 0;
+}
+
+int LuaDriver::lge_set_3d_instance_retained(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    lua_Integer instanceId = luaL_checkinteger(L, 1);
+    int slot = slot3d(self->instances3d_, instanceId);
+    if (slot < 0)
+    {
+        return luaL_error(L, "lge.set_3d_instance_retained: invalid instance id %d", (int)instanceId);
+    }
+
+    self->instances3d_[slot].retained = lua_toboolean(L, 2);
+    return 0;
+}
+
+int LuaDriver::lge_set_3d_instance_smooth(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
+
+    lua_Integer instanceId = luaL_checkinteger(L, 1);
+    int slot = slot3d(self->instances3d_, instanceId);
+    if (slot < 0)
+    {
+        return luaL_error(L, "lge.set_3d_instance_smooth: invalid instance id %d", (int)instanceId);
+    }
+
+    Instance3D &inst = self->instances3d_[slot];
+    inst.smooth = lua_toboolean(L, 2);
+    inst.poseCached = false;
+
+    // Vertex normals take as much RAM as the positions, so only models drawn smooth get them
+    Model3D &model = self->models3d_[inst.modelIndex];
+    if (inst.smooth && model.vertexNormalStore.empty())
+        computeVertexNormals(model);
+    return 0;
+}
+
+int LuaDriver::lge_set_3d_model_fixed_point(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self)
+        return 0;
 
+    lua_Integer modelId = luaL_checkinteger(L, 1);
+    int slot = slot3d(self->models3d_, modelId);
+    if (slot < 0)
+    {
+        return luaL_error(L, "lge.set_3d_model_fixed_point: invalid model id %d", (int)modelId);
+    }
+
+    self->models3d_[slot].fixedPoint = lua_toboolean(L, 2);
+    ++self->view3dGeneration_; // cached poses of its instances were transformed the other way
     return 0;
 }
 
+int LuaDriver::lge_draw_3d_instance(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self || !self->spr_)
+        return 0;
+
+    lua_Integer instanceId = luaL_checkinteger(L, 1);
+    float wx = (float)luaL_checknumber(L, 2);     // world x
+    float wy = (float)luaL_checknumber(L, 3);     // world y
+    float wz = (float)luaL_checknumber(L, 4);     // world z (distance from camera)
+    float radius = (float)luaL_checknumber(L, 5); // desired approx 2D radius at depth wz
+    float ax = (float)luaL_checknumber(L, 6);
+    float ay = (float)luaL_checknumber(L, 7);
+    float az = (float)luaL_checknumber(L, 8);
+
+    size_t vertexBase = 0;
+    int visCount = 0;
+    bool visible = self->queue3dInstance(instanceId, wx, wy, wz, radius, ax, ay, az, 0, vertexBase, visCount);
+    if (visCount > 0)
+        self->draw3dFaces(visCount, 1);
+
+    lua_pushboolean(L, visible);
+    return 1;
+}
+
+int LuaDriver::lge_draw_3d_instances(lua_State *L)
+{
+    LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
+    if (!self || !self->spr_)
+        return 0;
+
+    luaL_checktype(L, 1, LUA_TTABLE); // params_flat, 8 numbers per instance
+    int available = (int)(lua_rawlen(L, 1) / 8);
+    int count = (int)luaL_optinteger(L, 2, available);
+    if (count > available)
+        count = available;
+
+    size_t vertexBase = 0;
+    int visCount = 0;
+    int slotCount = 0;
+    int visibleInstances = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        // The id is read as an integer, its generation bits don't survive a float
+        lua_rawgeti(L, 1, i * 8 + 1);
+        lua_Integer instanceId = luaL_checkinteger(L, -1);
+        lua_pop(L, 1);
+
+        float p[7];
+        for (int k = 0; k < 7; ++k)
+        {
+            lua_rawgeti(L, 1, i * 8 + k + 2);
+            p[k] = (float)luaL_checknumber(L, -1);
+            lua_pop(L, 1);
+        }
+
+        // Every instance gets its own slot so dirty regions stay tight around each object
+        if (self->queue3dInstance(instanceId, p[0], p[1], p[2], p[3], p[4], p[5], p[6], slotCount, vertexBase, visCount))
+            ++visibleInstances;
+        ++slotCount;
+    }
+
+    if (visCount > 0)
+        self->draw3dFaces(visCount, slotCount);
+
+    lua_pushinteger(L, visibleInstances);
+    return 1;
+}
+
 int LuaDriver::lge_set_3d_light(lua_State *L)
 {
     LuaDriver *self = (LuaDriver *)lua_touserdata(L, lua_upvalueindex(1));
@@ -1357,6 +3810,8 @@ int LuaDriver::lge_set_3d_light(lua_State *L)
     float ambient = (float)luaL_optnumber(L, 4, 0.2f); // Ambient [0..1], the higher, the brighter
     float diffuse = (float)luaL_optnumber(L, 5, 0.8f); // Diffuse [0..1], the higher, the stronger the light - Should sum to 1.0 with ambient
 
+    self->view3dGeneration_++; // cached instance colors are stale
+
     float len = std::sqrt(dx * dx + dy * dy + dz * dz);
     if (len < 1e-4f)
     {
@@ -0,0 +1,71 @@
+#include "meshFormat.hpp"
+#include <cstring>
+
+static inline size_t alignUp4(size_t n)
+{
+    return (n + 3) & ~(size_t)3;
+}
+
+bool isMeshBlob(const void *data, size_t size)
+{
+    uint32_t magic;
+    if (!data || size < sizeof(magic))
+        return false;
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == MESH_MAGIC;
+}
+
+const char *parseMeshBlob(const void *data, size_t size, MeshView &view)
+{
+    if (!isMeshBlob(data, size) || size < sizeof(MeshHeader))
+        return "not a mesh blob";
+    if (((uintptr_t)data & 3) != 0)
+        return "mesh blob is not 4-byte aligned";
+
+    const uint8_t *base = (const uint8_t *)data;
+    const MeshHeader *header = (const MeshHeader *)base;
+    if (header->version != MESH_VERSION)
+        return "unsupported mesh version";
+    if (!(header->vertexScale > 0.0f))
+        return "invalid vertex scale";
+
+    bool index8 = (header->flags & MESH_FLAG_INDEX8) != 0;
+    size_t vertexCount = header->vertexCount;
+    size_t faceCount = header->faceCount;
+    if (index8 && vertexCount > 256)
+        return "8-bit indices with more than 256 vertices";
+
+    size_t verticesAt = sizeof(MeshHeader);
+    size_t indicesAt = alignUp4(verticesAt + vertexCount * 3 * sizeof(int16_t));
+    size_t normalsAt = alignUp4(indicesAt + faceCount * 3 * (index8 ? 1 : 2));
+    size_t planesAt = alignUp4(normalsAt + faceCount * 3 * sizeof(int16_t));
+    bool hasSource = (header->flags & MESH_FLAG_FACE_SOURCE) != 0;
+    size_t sourceAt = alignUp4(planesAt + faceCount * sizeof(float));
+    size_t end = hasSource ? sourceAt + faceCount * sizeof(uint16_t) : planesAt + faceCount * sizeof(float);
+    if (size < end)
+        return "mesh blob is truncated";
+    if (header->nextOffset != 0 && (header->nextOffset < end || header->nextOffset >= size || (header->nextOffset & 3) != 0))
+        return "invalid offset to the next level of detail";
+
+    view = MeshView();
+    view.header = header;
+    view.vertices = (const int16_t *)(base + verticesAt);
+    if (index8)
+        view.indices8 = base + indicesAt;
+    else
+        view.indices16 = (const uint16_t *)(base + indicesAt);
+    view.faceNormals = (const int16_t *)(base + normalsAt);
+    view.facePlaneD = (const float *)(base + planesAt);
+    if (hasSource)
+        view.faceSource = (const uint16_t *)(base + sourceAt);
+
+    // The renderer indexes vertices without bounds checks
+    for (size_t i = 0; i < faceCount * 3; ++i)
+    {
+        size_t index = index8 ? view.indices8[i] : view.indices16[i];
+        if (index >= vertexCount)
+            return "vertex index out of range";
+    }
+
+    return nullptr;
+}
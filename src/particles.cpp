@@ -0,0 +1,112 @@
+#include "particles.hpp"
+#include "fastTrig.hpp"
+#include <algorithm>
+#include <cmath>
+
+ParticleEmitter::ParticleEmitter(const EmitterParams &params, uint32_t seed)
+    : params_(params), count_(0), rng_(seed ? seed : 0x9E3779B9u), ageRemainderUs_(0)
+{
+    params_.capacity = std::max(1, std::min(PARTICLE_MAX_CAPACITY, params_.capacity));
+    if (params_.lifeMax < params_.lifeMin)
+        std::swap(params_.lifeMin, params_.lifeMax);
+    if (params_.speedMax < params_.speedMin)
+        std::swap(params_.speedMin, params_.speedMax);
+
+    int capacity = params_.capacity;
+    x_.resize(capacity);
+    y_.resize(capacity);
+    vx_.resize(capacity);
+    vy_.resize(capacity);
+    ageMs_.resize(capacity);
+    lifeMs_.resize(capacity);
+    color_.resize(capacity);
+}
+
+float ParticleEmitter::nextRandom()
+{
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return (rng_ >> 8) * (1.0f / 16777216.0f);
+}
+
+int ParticleEmitter::burst(float x, float y, int count, uint16_t color565)
+{
+    int spawned = 0;
+    int32_t fx = (int32_t)(x * PARTICLE_FP_ONE);
+    int32_t fy = (int32_t)(y * PARTICLE_FP_ONE);
+
+    while (spawned < count && count_ < params_.capacity)
+    {
+        int i = count_++;
+
+        // Trig only at birth, the update loop is integer-only
+        float a = params_.angle + (nextRandom() - 0.5f) * params_.spread;
+        float speed = params_.speedMin + nextRandom() * (params_.speedMax - params_.speedMin);
+        float life = params_.lifeMin + nextRandom() * (params_.lifeMax - params_.lifeMin);
+
+        x_[i] = fx;
+        y_[i] = fy;
+        float s, c;
+        fastSinCos(a, s, c);
+        vx_[i] = (int32_t)(c * speed * PARTICLE_FP_ONE);
+        vy_[i] = (int32_t)(s * speed * PARTICLE_FP_ONE);
+        ageMs_[i] = 0;
+        lifeMs_[i] = (uint16_t)std::max(1.0f, std::min(65535.0f, life * 1000.0f));
+        color_[i] = color565;
+        ++spawned;
+    }
+
+    return spawned;
+}
+
+void ParticleEmitter::update(float dt)
+{
+    if (dt <= 0.0f)
+        return;
+
+    // dt as 16.16 seconds, so v * dt >> 16 stays in 24.8 pixels
+    int32_t dtQ16 = (int32_t)(dt * 65536.0f);
+    // Ages count whole milliseconds, the rest is carried so short or fractional frames still add up
+    int32_t dtUs = (int32_t)(std::min(dt, 65.535f) * 1000000.0f + 0.5f) + ageRemainderUs_;
+    int32_t dtMs = dtUs / 1000;
+    ageRemainderUs_ = dtUs - dtMs * 1000;
+    int32_t gravityStep = (int32_t)(((int64_t)(params_.gravity * PARTICLE_FP_ONE) * dtQ16) >> 16);
+
+    int i = 0;
+    while (i < count_)
+    {
+        int32_t age = ageMs_[i] + dtMs;
+        if (age >= lifeMs_[i])
+        {
+            // Swap-remove: move the last live particle into this slot
+            int last = --count_;
+            x_[i] = x_[last];
+            y_[i] = y_[last];
+            vx_[i] = vx_[last];
+            vy_[i] = vy_[last];
+            ageMs_[i] = ageMs_[last];
+            lifeMs_[i] = lifeMs_[last];
+            color_[i] = color_[last];
+            continue; // Re-check the particle that was moved in
+        }
+        ageMs_[i] = (uint16_t)age;
+
+        // Semi-implicit Euler
+        vy_[i] += gravityStep;
+        x_[i] += (int32_t)(((int64_t)vx_[i] * dtQ16) >> 16);
+        y_[i] += (int32_t)(((int64_t)vy_[i] * dtQ16) >> 16);
+        ++i;
+    }
+}
+
+int ParticleEmitter::radius(int i) const
+{
+    int size = params_.size;
+    if (!params_.shrink || size <= 1)
+        return size;
+
+    int remaining = lifeMs_[i] - ageMs_[i];
+    int r = (size * remaining + lifeMs_[i] - 1) / lifeMs_[i];
+    return std::max(1, r);
+}
@@ -0,0 +1,350 @@
+#include "physicsWorld.hpp"
+#include <algorithm>
+#include <cmath>
+
+// Positional correction, keeps resting contacts from sinking
+static constexpr float CORRECTION_PERCENT = 0.8f;
+static constexpr float CORRECTION_SLOP = 0.05f;
+
+PhysicsWorld::PhysicsWorld(const PhysicsParams &params)
+    : params_(params), accumulator_(0.0f), slotCount_(0)
+{
+    params_.capacity = std::max(1, params_.capacity);
+    params_.maxSubsteps = std::max(1, params_.maxSubsteps);
+    if (params_.fixedDt <= 0.0f)
+        params_.fixedDt = 1.0f / 60.0f;
+
+    int capacity = params_.capacity;
+    x_.resize(capacity);
+    y_.resize(capacity);
+    vx_.resize(capacity);
+    vy_.resize(capacity);
+    halfW_.resize(capacity);
+    halfH_.resize(capacity);
+    invMass_.resize(capacity);
+    restitution_.resize(capacity);
+    shape_.resize(capacity);
+    active_.resize(capacity, 0);
+    freeIds_.reserve(capacity);
+    order_.reserve(capacity);
+
+    // Pop order hands out low ids first
+    for (int i = capacity - 1; i >= 0; --i)
+        freeIds_.push_back(i);
+}
+
+int PhysicsWorld::allocate(float x, float y, float hw, float hh, float vx, float vy, float mass, float restitution, BodyShape shape)
+{
+    if (freeIds_.empty())
+        return -1;
+
+    int id = freeIds_.back();
+    freeIds_.pop_back();
+
+    x_[id] = x;
+    y_[id] = y;
+    vx_[id] = vx;
+    vy_[id] = vy;
+    halfW_[id] = hw;
+    halfH_[id] = hh;
+    invMass_[id] = (mass > 0.0f) ? 1.0f / mass : 0.0f;
+    restitution_[id] = std::max(0.0f, std::min(1.0f, restitution));
+    shape_[id] = shape;
+    active_[id] = 1;
+
+    order_.push_back(id);
+    slotCount_ = std::max(slotCount_, id + 1);
+    return id;
+}
+
+int PhysicsWorld::addCircle(float x, float y, float r, float vx, float vy, float mass, float restitution)
+{
+    return allocate(x, y, r, r, vx, vy, mass, restitution, BODY_CIRCLE);
+}
+
+int PhysicsWorld::addRect(float x, float y, float w, float h, float vx, float vy, float mass, float restitution)
+{
+    return allocate(x, y, w * 0.5f, h * 0.5f, vx, vy, mass, restitution, BODY_AABB);
+}
+
+bool PhysicsWorld::isValid(int id) const
+{
+    return id >= 0 && id < params_.capacity && active_[id];
+}
+
+bool PhysicsWorld::remove(int id)
+{
+    if (!isValid(id))
+        return false;
+
+    active_[id] = 0;
+    freeIds_.push_back(id);
+    order_.erase(std::find(order_.begin(), order_.end(), id));
+
+    while (slotCount_ > 0 && !active_[slotCount_ - 1])
+        --slotCount_;
+    return true;
+}
+
+bool PhysicsWorld::setPosition(int id, float x, float y)
+{
+    if (!isValid(id))
+        return false;
+
+    x_[id] = x;
+    y_[id] = y;
+    return true;
+}
+
+bool PhysicsWorld::setVelocity(int id, float vx, float vy)
+{
+    if (!isValid(id))
+        return false;
+
+    vx_[id] = vx;
+    vy_[id] = vy;
+    return true;
+}
+
+int PhysicsWorld::step(float dt)
+{
+    if (dt <= 0.0f)
+        return 0;
+
+    accumulator_ += dt;
+
+    int steps = 0;
+    while (accumulator_ >= params_.fixedDt && steps < params_.maxSubsteps)
+    {
+        substep(params_.fixedDt);
+        accumulator_ -= params_.fixedDt;
+        ++steps;
+    }
+
+    // Falling behind: drop the backlog instead of spiralling
+    if (steps == params_.maxSubsteps && accumulator_ >= params_.fixedDt)
+        accumulator_ = 0.0f;
+
+    return steps;
+}
+
+void PhysicsWorld::substep(float dt)
+{
+    float gx = params_.gravityX * dt;
+    float gy = params_.gravityY * dt;
+
+    // 1. Integrate (semi-implicit Euler)
+    for (int id : order_)
+    {
+        if (invMass_[id] > 0.0f)
+        {
+            vx_[id] += gx;
+            vy_[id] += gy;
+        }
+        x_[id] += vx_[id] * dt;
+        y_[id] += vy_[id] * dt;
+
+        if (params_.walls)
+            collideWalls(id);
+    }
+
+    // 2. Broadphase: sweep and prune on X
+    sortAxis();
+
+    int n = (int)order_.size();
+    for (int i = 0; i < n; ++i)
+    {
+        int a = order_[i];
+        float maxX = x_[a] + halfW_[a];
+
+        for (int j = i + 1; j < n; ++j)
+        {
+            int b = order_[j];
+            if (x_[b] - halfW_[b] > maxX)
+                break; // Sorted by min X, nothing further can overlap
+
+            if (std::fabs(y_[a] - y_[b]) > halfH_[a] + halfH_[b])
+                continue;
+
+            // 3. Narrowphase and impulse
+            resolve(a, b);
+        }
+    }
+}
+
+void PhysicsWorld::sortAxis()
+{
+    // Insertion sort by min X, near O(n) frame to frame
+    int n = (int)order_.size();
+    for (int i = 1; i < n; ++i)
+    {
+        int id = order_[i];
+        float key = x_[id] - halfW_[id];
+
+        int j = i - 1;
+        while (j >= 0 && x_[order_[j]] - halfW_[order_[j]] > key)
+        {
+            order_[j + 1] = order_[j];
+            --j;
+        }
+        order_[j + 1] = id;
+    }
+}
+
+void PhysicsWorld::collideWalls(int i)
+{
+    float e = restitution_[i];
+    float hw = halfW_[i];
+    float hh = halfH_[i];
+
+    if (x_[i] - hw < 0.0f && vx_[i] < 0.0f)
+    {
+        x_[i] = hw;
+        vx_[i] = -vx_[i] * e;
+    }
+    else if (x_[i] + hw > params_.width && vx_[i] > 0.0f)
+    {
+        x_[i] = params_.width - hw;
+        vx_[i] = -vx_[i] * e;
+    }
+
+    if (y_[i] - hh < 0.0f && vy_[i] < 0.0f)
+    {
+        y_[i] = hh;
+        vy_[i] = -vy_[i] * e;
+    }
+    else if (y_[i] + hh > params_.height && vy_[i] > 0.0f)
+    {
+        y_[i] = params_.height - hh;
+        vy_[i] = -vy_[i] * e;
+    }
+}
+
+void PhysicsWorld::resolve(int a, int b)
+{
+    float invSum = invMass_[a] + invMass_[b];
+    if (invSum <= 0.0f)
+        return; // Two static bodies
+
+    // Contact normal (from a to b) and penetration depth
+    float nx = 0.0f;
+    float ny = 0.0f;
+    float penetration = 0.0f;
+
+    float dx = x_[b] - x_[a];
+    float dy = y_[b] - y_[a];
+
+    if (shape_[a] == BODY_CIRCLE && shape_[b] == BODY_CIRCLE)
+    {
+        float r = halfW_[a] + halfW_[b];
+        float distSq = dx * dx + dy * dy;
+        if (distSq >= r * r)
+            return;
+
+        float dist = std::sqrt(distSq);
+        if (dist > 1e-4f)
+        {
+            nx = dx / dist;
+            ny = dy / dist;
+        }
+        else
+        {
+            nx = 1.0f; // Coincident centers, pick any axis
+        }
+        penetration = r - dist;
+    }
+    else if (shape_[a] == BODY_AABB && shape_[b] == BODY_AABB)
+    {
+        float overlapX = halfW_[a] + halfW_[b] - std::fabs(dx);
+        float overlapY = halfH_[a] + halfH_[b] - std::fabs(dy);
+        if (overlapX <= 0.0f || overlapY <= 0.0f)
+            return;
+
+        // Separate along the axis of least penetration
+        if (overlapX < overlapY)
+        {
+            nx = (dx < 0.0f) ? -1.0f : 1.0f;
+            penetration = overlapX;
+        }
+        else
+        {
+            ny = (dy < 0.0f) ? -1.0f : 1.0f;
+            penetration = overlapY;
+        }
+    }
+    else
+    {
+        // Circle vs box, computed from the box's point of view
+        bool circleIsA = (shape_[a] == BODY_CIRCLE);
+        int box = circleIsA ? b : a;
+        int circle = circleIsA ? a : b;
+
+        float relX = x_[circle] - x_[box];
+        float relY = y_[circle] - y_[box];
+        float hw = halfW_[box];
+        float hh = halfH_[box];
+        float r = halfW_[circle];
+
+        float closestX = std::max(-hw, std::min(relX, hw));
+        float closestY = std::max(-hh, std::min(relY, hh));
+        bool inside = (closestX == relX && closestY == relY);
+
+        float cnx, cny; // Normal pointing from box to circle
+        if (inside)
+        {
+            // Center inside the box: push out along the nearest face
+            float toX = hw - std::fabs(relX);
+            float toY = hh - std::fabs(relY);
+            if (toX < toY)
+            {
+                cnx = (relX < 0.0f) ? -1.0f : 1.0f;
+                cny = 0.0f;
+                penetration = toX + r;
+            }
+            else
+            {
+                cnx = 0.0f;
+                cny = (relY < 0.0f) ? -1.0f : 1.0f;
+                penetration = toY + r;
+            }
+        }
+        else
+        {
+            float ox = relX - closestX;
+            float oy = relY - closestY;
+            float distSq = ox * ox + oy * oy;
+            if (distSq >= r * r)
+                return;
+
+            float dist = std::sqrt(distSq);
+            cnx = ox / dist;
+            cny = oy / dist;
+            penetration = r - dist;
+        }
+
+        // Flip to the a -> b convention
+        nx = circleIsA ? -cnx : cnx;
+        ny = circleIsA ? -cny : cny;
+    }
+
+    // Impulse along the normal, only if the bodies approach each other
+    float rvx = vx_[b] - vx_[a];
+    float rvy = vy_[b] - vy_[a];
+    float velAlongNormal = rvx * nx + rvy * ny;
+    if (velAlongNormal < 0.0f)
+    {
+        float e = std::min(restitution_[a], restitution_[b]);
+        float j = -(1.0f + e) * velAlongNormal / invSum;
+        vx_[a] -= j * invMass_[a] * nx;
+        vy_[a] -= j * invMass_[a] * ny;
+        vx_[b] += j * invMass_[b] * nx;
+        vy_[b] += j * invMass_[b] * ny;
+    }
+
+    // Positional correction
+    float correction = std::max(penetration - CORRECTION_SLOP, 0.0f) / invSum * CORRECTION_PERCENT;
+    x_[a] -= correction * invMass_[a] * nx;
+    y_[a] -= correction * invMass_[a] * ny;
+    x_[b] += correction * invMass_[b] * nx;
+    y_[b] += correction * invMass_[b] * ny;
+}
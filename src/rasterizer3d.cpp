@@ -0,0 +1,310 @@
+#include "rasterizer3d.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Below this magnitude (28.4 units, 1024 pixels) edge setup fits 32-bit arithmetic
+static constexpr int32_t NARROW_LIMIT = 1 << 14;
+
+// First row whose pixel center (row * 16 + 8) is at or below the 28.4 y coordinate
+static inline int firstRowAtOrBelow(int32_t y)
+{
+    return (y - 8 + 15) >> 4;
+}
+
+void Rasterizer3D::setTarget(uint8_t *buffer, int width, int height)
+{
+    buffer_ = buffer;
+    width_ = width;
+    height_ = height;
+}
+
+// Floor quotient and non-negative remainder for a positive divisor
+template <typename T>
+static inline void floorDivMod(T n, T d, int32_t &quotient, int32_t &remainder)
+{
+    T q = n / d;
+    T r = n - q * d;
+    if (r < 0)
+    {
+        --q;
+        r += d;
+    }
+    quotient = (int32_t)q;
+    remainder = (int32_t)r;
+}
+
+Rasterizer3D::Edge Rasterizer3D::setupEdge(int32_t xa, int32_t ya, int32_t xb, int32_t yb, int row, bool wide)
+{
+    // Only called for edges spanning at least one row center, so yb > ya.
+    // First covered column at a row: ceil((xEdge - 8) / 16), kept exactly as quotient + remainder
+    // so shared edges resolve identically in both triangles.
+    int32_t dx = xb - xa;
+    int32_t dy = yb - ya;
+    int32_t denom = dy * 16;
+    int32_t rowOffset = row * 16 + 8 - ya;
+
+    Edge e;
+    e.denom = denom;
+    if (wide)
+    {
+        int64_t numer = (int64_t)(xa - 8) * dy + (int64_t)rowOffset * dx + denom - 1;
+        floorDivMod<int64_t>(numer, denom, e.x, e.err);
+    }
+    else
+    {
+        int32_t numer = (xa - 8) * dy + rowOffset * dx + denom - 1;
+        floorDivMod<int32_t>(numer, denom, e.x, e.err);
+    }
+
+    // Within the guard band the per-row terms always fit 32 bits
+    floorDivMod<int32_t>(dx * 16, denom, e.step, e.errStep);
+    return e;
+}
+
+void Rasterizer3D::fillRows(int yStart, int yEnd, Edge &left, Edge &right, uint8_t color)
+{
+    uint8_t *row = buffer_ + yStart * width_;
+    for (int y = yStart; y < yEnd; ++y)
+    {
+        // Columns whose centers fall in [left, right)
+        int x1 = left.x;
+        int x2 = right.x;
+        if (x1 < 0)
+            x1 = 0;
+        if (x2 > width_)
+            x2 = width_;
+        if (x2 > x1)
+        {
+            if (shade_)
+                fillSpanShaded(row, y, x1, x2);
+            else if (texture_)
+                fillSpanTextured(row, y, x1, x2);
+            else
+                std::memset(row + x1, color, x2 - x1);
+        }
+
+        left.advance();
+        right.advance();
+        row += width_;
+    }
+}
+
+void Rasterizer3D::fillSpanShaded(uint8_t *row, int y, int x1, int x2) const
+{
+    const ShadePlane &p = *shade_;
+    const uint8_t *ramp = p.ramp;
+    float start = p.s0 + p.dsdx * x1 + p.dsdy * y;
+    float end = start + p.dsdx * (x2 - 1 - x1);
+
+    if (start >= p.lo && start <= p.hi && end >= p.lo && end <= p.hi)
+    {
+        // Linear along the span, so every pixel lies between the ends: step in 8.16 without clamping
+        int32_t s = (int32_t)(start * 256.0f);
+        int32_t step = (int32_t)(p.dsdx * 256.0f);
+        for (int x = x1; x < x2; ++x)
+        {
+            row[x] = ramp[s >> 16];
+            s += step;
+        }
+        return;
+    }
+
+    // Snapped vertices can put pixel centers slightly outside the shade range
+    for (int x = x1; x < x2; ++x)
+    {
+        float s = std::max(p.lo, std::min(p.hi, start + p.dsdx * (x - x1)));
+        row[x] = ramp[(int)s >> 8];
+    }
+}
+
+// Texels to 16.16, clamped so slivers with huge gradients can't overflow the conversion
+static inline uint32_t toTexel16(float t)
+{
+    t = std::max(-2.0f * Rasterizer3D::TEXTURE_UV_LIMIT, std::min(t, 2.0f * Rasterizer3D::TEXTURE_UV_LIMIT));
+    return (uint32_t)(int32_t)(t * 65536.0f);
+}
+
+void Rasterizer3D::fillSpanTextured(uint8_t *row, int y, int x1, int x2) const
+{
+    const TexturePlane &p = *texture_;
+    const uint8_t *texels = p.texels;
+    const uint8_t *remap = p.remap;
+    int widthLog2 = p.widthLog2;
+    uint32_t uMask = p.uMask;
+    uint32_t vMask = p.vMask;
+
+    // Unsigned 16.16 steps wrap modulo 2^16 texels, a multiple of any texture size
+    uint32_t u = toTexel16(p.u0 + p.dudx * x1 + p.dudy * y);
+    uint32_t v = toTexel16(p.v0 + p.dvdx * x1 + p.dvdy * y);
+    uint32_t du = toTexel16(p.dudx);
+    uint32_t dv = toTexel16(p.dvdx);
+
+    if (remap)
+    {
+        for (int x = x1; x < x2; ++x)
+        {
+            row[x] = remap[texels[(((v >> 16) & vMask) << widthLog2) | ((u >> 16) & uMask)]];
+            u += du;
+            v += dv;
+        }
+    }
+    else
+    {
+        for (int x = x1; x < x2; ++x)
+        {
+            row[x] = texels[(((v >> 16) & vMask) << widthLog2) | ((u >> 16) & uMask)];
+            u += du;
+            v += dv;
+        }
+    }
+}
+
+bool Rasterizer3D::fillTriangleTextured(int32_t X0, int32_t Y0, int32_t X1, int32_t Y1, int32_t X2, int32_t Y2,
+                                        const int32_t uv[6], const uint8_t *texels, int widthLog2, int heightLog2,
+                                        const uint8_t *remap)
+{
+    int64_t cross = (int64_t)(X1 - X0) * (Y2 - Y0) - (int64_t)(Y1 - Y0) * (X2 - X0);
+    if (cross == 0)
+        return true;
+
+    // Same plane setup as fillTriangleShaded, once for u and once for v
+    float inv = 16.0f / (float)cross;
+    float fx0 = 0.5f - X0 * (1.0f / 16.0f);
+    float fy0 = 0.5f - Y0 * (1.0f / 16.0f);
+    const float texel = 1.0f / 65536.0f;
+    float u0 = uv[0] * texel;
+    float v0 = uv[1] * texel;
+    float du1 = (uv[2] - uv[0]) * texel;
+    float dv1 = (uv[3] - uv[1]) * texel;
+    float du2 = (uv[4] - uv[0]) * texel;
+    float dv2 = (uv[5] - uv[1]) * texel;
+
+    TexturePlane plane;
+    plane.dudx = (du1 * (Y2 - Y0) - du2 * (Y1 - Y0)) * inv;
+    plane.dudy = (du2 * (X1 - X0) - du1 * (X2 - X0)) * inv;
+    plane.u0 = u0 + plane.dudx * fx0 + plane.dudy * fy0;
+    plane.dvdx = (dv1 * (Y2 - Y0) - dv2 * (Y1 - Y0)) * inv;
+    plane.dvdy = (dv2 * (X1 - X0) - dv1 * (X2 - X0)) * inv;
+    plane.v0 = v0 + plane.dvdx * fx0 + plane.dvdy * fy0;
+    plane.texels = texels;
+    plane.widthLog2 = widthLog2;
+    plane.uMask = (1u << widthLog2) - 1;
+    plane.vMask = (1u << heightLog2) - 1;
+    plane.remap = remap;
+
+    texture_ = &plane;
+    bool drawn = fillTriangleSubpixel(X0, Y0, X1, Y1, X2, Y2, 0);
+    texture_ = nullptr;
+    return drawn;
+}
+
+bool Rasterizer3D::fillTriangleShaded(int32_t X0, int32_t Y0, int32_t X1, int32_t Y1, int32_t X2, int32_t Y2,
+                                      uint16_t s0, uint16_t s1, uint16_t s2, const uint8_t *ramp)
+{
+    // Flat when there is nothing to interpolate
+    if (s0 == s1 && s1 == s2)
+        return fillTriangleSubpixel(X0, Y0, X1, Y1, X2, Y2, ramp[s0 >> 8]);
+
+    int64_t cross = (int64_t)(X1 - X0) * (Y2 - Y0) - (int64_t)(Y1 - Y0) * (X2 - X0);
+    if (cross == 0)
+        return true;
+
+    // Plane through the snapped vertices, gradients per pixel (positions are in 1/16 pixel)
+    float inv = 16.0f / (float)cross;
+    float ds1 = (float)s1 - s0;
+    float ds2 = (float)s2 - s0;
+    ShadePlane plane;
+    plane.dsdx = (ds1 * (Y2 - Y0) - ds2 * (Y1 - Y0)) * inv;
+    plane.dsdy = (ds2 * (X1 - X0) - ds1 * (X2 - X0)) * inv;
+    plane.s0 = s0 + plane.dsdx * (0.5f - X0 * (1.0f / 16.0f)) + plane.dsdy * (0.5f - Y0 * (1.0f / 16.0f));
+    plane.lo = std::min({s0, s1, s2});
+    plane.hi = std::max({s0, s1, s2});
+    plane.ramp = ramp;
+
+    shade_ = &plane;
+    bool drawn = fillTriangleSubpixel(X0, Y0, X1, Y1, X2, Y2, 0);
+    shade_ = nullptr;
+    return drawn;
+}
+
+bool Rasterizer3D::fillTriangle(float x0, float y0, float x1, float y1, float x2, float y2, uint8_t color)
+{
+    if (!buffer_)
+        return false;
+
+    if (!inGuardBand(x0, y0, x1, y1, x2, y2))
+        return false;
+
+    return fillTriangleSubpixel(toSubpixel(x0), toSubpixel(y0), toSubpixel(x1), toSubpixel(y1),
+                                toSubpixel(x2), toSubpixel(y2), color);
+}
+
+bool Rasterizer3D::fillTriangleSubpixel(int32_t X0, int32_t Y0, int32_t X1, int32_t Y1, int32_t X2, int32_t Y2,
+                                        uint8_t color)
+{
+    if (!buffer_)
+        return false;
+
+    // Sort by y: v0 top, v2 bottom
+    if (Y1 < Y0)
+    {
+        std::swap(X0, X1);
+        std::swap(Y0, Y1);
+    }
+    if (Y2 < Y0)
+    {
+        std::swap(X0, X2);
+        std::swap(Y0, Y2);
+    }
+    if (Y2 < Y1)
+    {
+        std::swap(X1, X2);
+        std::swap(Y1, Y2);
+    }
+
+    int yTop = firstRowAtOrBelow(Y0);
+    int yMid = firstRowAtOrBelow(Y1);
+    int yBottom = firstRowAtOrBelow(Y2);
+
+    // Clip rows once for the whole triangle
+    int yStart = std::max(yTop, 0);
+    int yEnd = std::min(yBottom, height_);
+    if (yStart >= yEnd)
+        return true;
+
+    // Which side of the long edge v0 -> v2 the middle vertex is on (zero area draws nothing)
+    int64_t cross = (int64_t)(X1 - X0) * (Y2 - Y0) - (int64_t)(Y1 - Y0) * (X2 - X0);
+    if (cross == 0)
+        return true;
+    bool longEdgeLeft = cross > 0;
+
+    // Large triangles need 64-bit products during edge setup
+    bool wide = std::max({std::abs(X0), std::abs(X1), std::abs(X2), std::abs(Y0), std::abs(Y1), std::abs(Y2)}) >= NARROW_LIMIT;
+
+    Edge longEdge = setupEdge(X0, Y0, X2, Y2, yStart, wide);
+
+    // Upper half: v0 -> v1
+    int upperEnd = std::min(yMid, yEnd);
+    if (yStart < upperEnd)
+    {
+        Edge shortEdge = setupEdge(X0, Y0, X1, Y1, yStart, wide);
+        if (longEdgeLeft)
+            fillRows(yStart, upperEnd, longEdge, shortEdge, color);
+        else
+            fillRows(yStart, upperEnd, shortEdge, longEdge, color);
+    }
+
+    // Lower half: v1 -> v2, the long edge continues from where the upper half left it
+    int lowerStart = std::max(yMid, yStart);
+    if (lowerStart < yEnd)
+    {
+        Edge shortEdge = setupEdge(X1, Y1, X2, Y2, lowerStart, wide);
+        if (longEdgeLeft)
+            fillRows(lowerStart, yEnd, longEdge, shortEdge, color);
+        else
+            fillRows(lowerStart, yEnd, shortEdge, longEdge, color);
+    }
+
+    return true;
+}
@@ -0,0 +1,307 @@
+#include "tileDepthRenderer.hpp"
+#include "rasterizer3d.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void TileDepthRenderer::begin(int width, int height)
+{
+    width_ = width;
+    height_ = height;
+    tilesX_ = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY_ = (height + TILE_SIZE - 1) / TILE_SIZE;
+    triangles_.clear();
+}
+
+bool TileDepthRenderer::addTriangle(float x0, float y0, float z0,
+                                    float x1, float y1, float z1,
+                                    float x2, float y2, float z2, uint8_t color)
+{
+    if (!Rasterizer3D::inGuardBand(x0, y0, x1, y1, x2, y2))
+        return false;
+
+    addTriangleSubpixel(Rasterizer3D::toSubpixel(x0), Rasterizer3D::toSubpixel(y0), z0,
+                        Rasterizer3D::toSubpixel(x1), Rasterizer3D::toSubpixel(y1), z1,
+                        Rasterizer3D::toSubpixel(x2), Rasterizer3D::toSubpixel(y2), z2, color);
+    return true;
+}
+
+void TileDepthRenderer::addTriangleSubpixel(int32_t x0, int32_t y0, float z0,
+                                            int32_t x1, int32_t y1, float z1,
+                                            int32_t x2, int32_t y2, float z2, uint8_t color,
+                                            const uint8_t *ramp, uint16_t s0, uint16_t s1, uint16_t s2)
+{
+    int32_t X[3] = {x0, x1, x2};
+    int32_t Y[3] = {y0, y1, y2};
+    float Z[3] = {z0, z1, z2};
+    float A[3][ATTR_COUNT] = {{(float)s0, 0.0f, 0.0f}, {(float)s1, 0.0f, 0.0f}, {(float)s2, 0.0f, 0.0f}};
+
+    Triangle t;
+    t.color = color;
+    t.ramp = ramp;
+    t.texels = nullptr;
+    if (setupTriangle(X, Y, Z, A, t))
+        triangles_.push_back(t);
+}
+
+void TileDepthRenderer::addTriangleTextured(int32_t x0, int32_t y0, float z0,
+                                            int32_t x1, int32_t y1, float z1,
+                                            int32_t x2, int32_t y2, float z2,
+                                            const int32_t uv[6], const uint8_t *texels, int widthLog2, int heightLog2,
+                                            const uint8_t *remap)
+{
+    int32_t X[3] = {x0, x1, x2};
+    int32_t Y[3] = {y0, y1, y2};
+    float Z[3] = {z0, z1, z2};
+    float A[3][ATTR_COUNT];
+    for (int k = 0; k < 3; ++k)
+    {
+        A[k][ATTR_SHADE] = 0.0f;
+        A[k][ATTR_U] = uv[k * 2 + 0] * (1.0f / 65536.0f);
+        A[k][ATTR_V] = uv[k * 2 + 1] * (1.0f / 65536.0f);
+    }
+
+    Triangle t;
+    t.color = 0;
+    t.ramp = remap;
+    t.texels = texels;
+    t.widthLog2 = (uint8_t)widthLog2;
+    t.heightLog2 = (uint8_t)heightLog2;
+    if (setupTriangle(X, Y, Z, A, t))
+        triangles_.push_back(t);
+}
+
+// Edge functions, bounds and the 1/z and attribute planes. Returns false if the triangle covers no pixel.
+bool TileDepthRenderer::setupTriangle(int32_t X[3], int32_t Y[3], float z[3], float A[3][ATTR_COUNT], Triangle &t)
+{
+    // Bins index triangles with 16 bits
+    if (triangles_.size() >= 0xFFFF)
+        return false;
+
+    float W[3] = {1.0f / z[0], 1.0f / z[1], 1.0f / z[2]};
+
+    // Orient so the inside is where every edge function is positive (zero area draws nothing)
+    int64_t area = (int64_t)(X[1] - X[0]) * (Y[2] - Y[0]) - (int64_t)(Y[1] - Y[0]) * (X[2] - X[0]);
+    if (area == 0)
+        return false;
+    if (area < 0)
+    {
+        std::swap(X[1], X[2]);
+        std::swap(Y[1], Y[2]);
+        std::swap(W[1], W[2]);
+        std::swap(A[1], A[2]);
+    }
+
+    // Pixel bounds: columns and rows whose centers lie within the vertex range
+    int32_t minXs = std::min({X[0], X[1], X[2]});
+    int32_t maxXs = std::max({X[0], X[1], X[2]});
+    int32_t minYs = std::min({Y[0], Y[1], Y[2]});
+    int32_t maxYs = std::max({Y[0], Y[1], Y[2]});
+
+    int minX = std::max((minXs - 8 + 15) >> 4, 0);
+    int minY = std::max((minYs - 8 + 15) >> 4, 0);
+    int maxX = std::min((maxXs - 8) >> 4, width_ - 1);
+    int maxY = std::min((maxYs - 8) >> 4, height_ - 1);
+    if (minX > maxX || minY > maxY)
+        return false;
+
+    for (int e = 0; e < 3; ++e)
+    {
+        int i = e;
+        int j = (e + 1) % 3;
+        int32_t dx = X[j] - X[i];
+        int32_t dy = Y[j] - Y[i];
+
+        // E(p) = dx * (py - Yi) - dy * (px - Xi), evaluated at pixel centers (16 * x + 8)
+        t.edgeA[e] = -dy * 16;
+        t.edgeB[e] = dx * 16;
+        t.edgeC[e] = (int64_t)dx * (8 - Y[i]) - (int64_t)dy * (8 - X[i]);
+
+        // Top-left rule: centers exactly on other edges belong to the neighbouring triangle
+        bool topLeft = (dy < 0) || (dy == 0 && dx > 0);
+        if (!topLeft)
+            t.edgeC[e] -= 1;
+    }
+
+    // 1/z is linear in screen space: plane through the three snapped vertices
+    float fx0 = X[0] * (1.0f / 16.0f), fy0 = Y[0] * (1.0f / 16.0f);
+    float ex1 = (X[1] - X[0]) * (1.0f / 16.0f), ey1 = (Y[1] - Y[0]) * (1.0f / 16.0f);
+    float ex2 = (X[2] - X[0]) * (1.0f / 16.0f), ey2 = (Y[2] - Y[0]) * (1.0f / 16.0f);
+    float det = ex1 * ey2 - ex2 * ey1;
+    float dw1 = W[1] - W[0];
+    float dw2 = W[2] - W[0];
+
+    t.dwdx = (dw1 * ey2 - dw2 * ey1) / det;
+    t.dwdy = (dw2 * ex1 - dw1 * ex2) / det;
+    t.w0 = W[0] + t.dwdx * (0.5f - fx0) + t.dwdy * (0.5f - fy0);
+    t.wMin = std::min({W[0], W[1], W[2]});
+    t.wMax = std::max({W[0], W[1], W[2]});
+
+    // Shade (Gouraud) and texture coordinates (affine) are linear in screen space too, same plane setup
+    for (int a = 0; a < ATTR_COUNT; ++a)
+    {
+        float da1 = A[1][a] - A[0][a];
+        float da2 = A[2][a] - A[0][a];
+        t.dadx[a] = (da1 * ey2 - da2 * ey1) / det;
+        t.dady[a] = (da2 * ex1 - da1 * ex2) / det;
+        t.a0[a] = A[0][a] + t.dadx[a] * (0.5f - fx0) + t.dady[a] * (0.5f - fy0);
+    }
+    t.sMin = std::min({A[0][ATTR_SHADE], A[1][ATTR_SHADE], A[2][ATTR_SHADE]});
+    t.sMax = std::max({A[0][ATTR_SHADE], A[1][ATTR_SHADE], A[2][ATTR_SHADE]});
+
+    t.minX = (int16_t)minX;
+    t.minY = (int16_t)minY;
+    t.maxX = (int16_t)maxX;
+    t.maxY = (int16_t)maxY;
+    return true;
+}
+
+void TileDepthRenderer::buildBins()
+{
+    int tileCount = tilesX_ * tilesY_;
+    binStart_.assign(tileCount + 1, 0);
+
+    // Counting sort of (triangle, tile) pairs by tile
+    for (const Triangle &t : triangles_)
+    {
+        for (int ty = t.minY / TILE_SIZE; ty <= t.maxY / TILE_SIZE; ++ty)
+            for (int tx = t.minX / TILE_SIZE; tx <= t.maxX / TILE_SIZE; ++tx)
+                binStart_[ty * tilesX_ + tx + 1]++;
+    }
+    for (int i = 0; i < tileCount; ++i)
+        binStart_[i + 1] += binStart_[i];
+
+    binned_.resize(binStart_[tileCount]);
+    for (size_t n = 0; n < triangles_.size(); ++n)
+    {
+        const Triangle &t = triangles_[n];
+        for (int ty = t.minY / TILE_SIZE; ty <= t.maxY / TILE_SIZE; ++ty)
+            for (int tx = t.minX / TILE_SIZE; tx <= t.maxX / TILE_SIZE; ++tx)
+                binned_[binStart_[ty * tilesX_ + tx]++] = (uint16_t)n;
+    }
+
+    // binStart_[i] was used as the write cursor and now holds the end of bin i
+    for (int i = tileCount; i > 0; --i)
+        binStart_[i] = binStart_[i - 1];
+    binStart_[0] = 0;
+}
+
+void TileDepthRenderer::renderTile(uint8_t *buffer, int tx, int ty, bool &touched)
+{
+    int start = binStart_[ty * tilesX_ + tx];
+    int end = binStart_[ty * tilesX_ + tx + 1];
+    if (start == end)
+        return;
+
+    int tileX1 = tx * TILE_SIZE;
+    int tileY1 = ty * TILE_SIZE;
+    int tileX2 = std::min(tileX1 + TILE_SIZE, width_) - 1;
+    int tileY2 = std::min(tileY1 + TILE_SIZE, height_) - 1;
+
+    // Quantize 1/z over the triangles in this tile only, 0 is "nothing drawn yet"
+    float wMin = triangles_[binned_[start]].wMin;
+    float wMax = triangles_[binned_[start]].wMax;
+    for (int n = start + 1; n < end; ++n)
+    {
+        const Triangle &t = triangles_[binned_[n]];
+        wMin = std::min(wMin, t.wMin);
+        wMax = std::max(wMax, t.wMax);
+    }
+    float scale = (wMax > wMin) ? 254.0f / (wMax - wMin) : 0.0f;
+
+    uint8_t depth[TILE_SIZE * TILE_SIZE];
+    std::memset(depth, 0, sizeof(depth));
+
+    for (int n = start; n < end; ++n)
+    {
+        const Triangle &t = triangles_[binned_[n]];
+
+        int x1 = std::max<int>(t.minX, tileX1);
+        int y1 = std::max<int>(t.minY, tileY1);
+        int x2 = std::min<int>(t.maxX, tileX2);
+        int y2 = std::min<int>(t.maxY, tileY2);
+        if (x1 > x2 || y1 > y2)
+            continue;
+
+        int64_t rowE0 = t.edgeC[0] + (int64_t)t.edgeA[0] * x1 + (int64_t)t.edgeB[0] * y1;
+        int64_t rowE1 = t.edgeC[1] + (int64_t)t.edgeA[1] * x1 + (int64_t)t.edgeB[1] * y1;
+        int64_t rowE2 = t.edgeC[2] + (int64_t)t.edgeA[2] * x1 + (int64_t)t.edgeB[2] * y1;
+
+        // Depth in quantized units, +1.5 maps wMin to 1 and rounds
+        float rowQ = (t.w0 + t.dwdx * x1 + t.dwdy * y1 - wMin) * scale + 1.5f;
+        float stepQ = t.dwdx * scale;
+
+        for (int y = y1; y <= y2; ++y)
+        {
+            int64_t e0 = rowE0;
+            int64_t e1 = rowE1;
+            int64_t e2 = rowE2;
+            float q = rowQ;
+            uint8_t *pixel = buffer + y * width_ + x1;
+            uint8_t *z = depth + (y - tileY1) * TILE_SIZE + (x1 - tileX1);
+
+            for (int x = x1; x <= x2; ++x)
+            {
+                if ((e0 | e1 | e2) >= 0)
+                {
+                    int d = (int)q;
+                    d = std::max(1, std::min(d, 255));
+                    if (d > *z)
+                    {
+                        *z = (uint8_t)d;
+                        if (t.texels)
+                        {
+                            // Floor, then wrap to the power-of-two size
+                            float u = t.a0[ATTR_U] + t.dadx[ATTR_U] * x + t.dady[ATTR_U] * y;
+                            float v = t.a0[ATTR_V] + t.dadx[ATTR_V] * x + t.dady[ATTR_V] * y;
+                            int iu = (int)std::floor(u) & ((1 << t.widthLog2) - 1);
+                            int iv = (int)std::floor(v) & ((1 << t.heightLog2) - 1);
+                            uint8_t texel = t.texels[(iv << t.widthLog2) | iu];
+                            *pixel = t.ramp ? t.ramp[texel] : texel;
+                        }
+                        else if (t.ramp)
+                        {
+                            float s = t.a0[ATTR_SHADE] + t.dadx[ATTR_SHADE] * x + t.dady[ATTR_SHADE] * y;
+                            *pixel = t.ramp[(int)std::max(t.sMin, std::min(t.sMax, s)) >> 8];
+                        }
+                        else
+                        {
+                            *pixel = t.color;
+                        }
+                        touched = true;
+                    }
+                }
+                e0 += t.edgeA[0];
+                e1 += t.edgeA[1];
+                e2 += t.edgeA[2];
+                q += stepQ;
+                ++pixel;
+                ++z;
+            }
+
+            rowE0 += t.edgeB[0];
+            rowE1 += t.edgeB[1];
+            rowE2 += t.edgeB[2];
+            rowQ += t.dwdy * scale;
+        }
+    }
+}
+
+void TileDepthRenderer::render(uint8_t *buffer, std::vector<uint16_t> &touchedTiles)
+{
+    if (!buffer || triangles_.empty())
+        return;
+
+    buildBins();
+
+    for (int ty = 0; ty < tilesY_; ++ty)
+    {
+        for (int tx = 0; tx < tilesX_; ++tx)
+        {
+            bool touched = false;
+            renderTile(buffer, tx, ty, touched);
+            if (touched)
+                touchedTiles.push_back((uint16_t)(ty * tilesX_ + tx));
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#include "tilemap.hpp"
+#include <algorithm>
+
+Tilemap::Tilemap(int cols, int rows, int tileW, int tileH)
+    : cols_(std::max(1, cols)), rows_(std::max(1, rows)), tileW_(std::max(1, tileW)), tileH_(std::max(1, tileH)),
+      scrollX_(0), scrollY_(0), allDirty_(true), lastVx_(0), lastVy_(0), lastVw_(0), lastVh_(0)
+{
+    int totalCells = cols_ * rows_;
+    cells_.resize(totalCells, 0);
+    dirty_.resize(totalCells, false);
+}
+
+uint8_t Tilemap::get(int col, int row) const
+{
+    if (col < 0 || col >= cols_ || row < 0 || row >= rows_)
+        return 0;
+
+    return cells_[getCellIndex(col, row)];
+}
+
+void Tilemap::set(int col, int row, uint8_t value)
+{
+    if (col < 0 || col >= cols_ || row < 0 || row >= rows_)
+        return;
+
+    int idx = getCellIndex(col, row);
+    if (cells_[idx] == value)
+        return; // Unchanged cells stay clean
+
+    cells_[idx] = value;
+    dirty_[idx] = true;
+}
+
+void Tilemap::fill(uint8_t value)
+{
+    for (int i = 0; i < (int)cells_.size(); ++i)
+    {
+        if (cells_[i] != value)
+        {
+            cells_[i] = value;
+            dirty_[i] = true;
+        }
+    }
+}
+
+void Tilemap::setScroll(int scrollX, int scrollY)
+{
+    if (scrollX == scrollX_ && scrollY == scrollY_)
+        return;
+
+    // Every visible cell moves on screen
+    scrollX_ = scrollX;
+    scrollY_ = scrollY;
+    allDirty_ = true;
+}
+
+void Tilemap::markAllDirty()
+{
+    allDirty_ = true;
+}
+
+void Tilemap::collectSpans(int vx, int vy, int vw, int vh, std::vector<TileSpan> &spans)
+{
+    spans.clear();
+
+    if (vx != lastVx_ || vy != lastVy_ || vw != lastVw_ || vh != lastVh_)
+    {
+        allDirty_ = true;
+        lastVx_ = vx;
+        lastVy_ = vy;
+        lastVw_ = vw;
+        lastVh_ = vh;
+    }
+
+    if (vw <= 0 || vh <= 0)
+        return;
+
+    // Screen position of cell (0, 0)
+    int originX = vx - scrollX_;
+    int originY = vy - scrollY_;
+
+    // Viewport area covered by the map
+    int mapX1 = std::max(vx, originX);
+    int mapY1 = std::max(vy, originY);
+    int mapX2 = std::min(vx + vw, originX + cols_ * tileW_); // exclusive
+    int mapY2 = std::min(vy + vh, originY + rows_ * tileH_); // exclusive
+
+    if (allDirty_)
+    {
+        // Background strips for the part of the viewport the map does not cover
+        if (mapX1 >= mapX2 || mapY1 >= mapY2)
+        {
+            spans.push_back({vx, vy, vw, vh, 0});
+        }
+        else
+        {
+            if (mapY1 > vy)
+                spans.push_back({vx, vy, vw, mapY1 - vy, 0});
+            if (mapY2 < vy + vh)
+                spans.push_back({vx, mapY2, vw, vy + vh - mapY2, 0});
+            if (mapX1 > vx)
+                spans.push_back({vx, mapY1, mapX1 - vx, mapY2 - mapY1, 0});
+            if (mapX2 < vx + vw)
+                spans.push_back({mapX2, mapY1, vx + vw - mapX2, mapY2 - mapY1, 0});
+        }
+    }
+
+    if (mapX1 < mapX2 && mapY1 < mapY2)
+    {
+        // Visible cell range
+        int col1 = (mapX1 - originX) / tileW_;
+        int col2 = (mapX2 - 1 - originX) / tileW_;
+        int row1 = (mapY1 - originY) / tileH_;
+        int row2 = (mapY2 - 1 - originY) / tileH_;
+
+        for (int row = row1; row <= row2; ++row)
+        {
+            int y1 = std::max(mapY1, originY + row * tileH_);
+            int y2 = std::min(mapY2, originY + (row + 1) * tileH_);
+
+            int col = col1;
+            while (col <= col2)
+            {
+                int idx = getCellIndex(col, row);
+                if (!allDirty_ && !dirty_[idx])
+                {
+                    ++col;
+                    continue;
+                }
+
+                // Extend the run over adjacent dirty cells of the same value
+                uint8_t value = cells_[idx];
+                int runEnd = col;
+                while (runEnd + 1 <= col2)
+                {
+                    int nextIdx = getCellIndex(runEnd + 1, row);
+                    if ((!allDirty_ && !dirty_[nextIdx]) || cells_[nextIdx] != value)
+                        break;
+                    ++runEnd;
+                }
+
+                int x1 = std::max(mapX1, originX + col * tileW_);
+                int x2 = std::min(mapX2, originX + (runEnd + 1) * tileW_);
+                spans.push_back({x1, y1, x2 - x1, y2 - y1, value});
+
+                col = runEnd + 1;
+            }
+        }
+    }
+
+    std::fill(dirty_.begin(), dirty_.end(), false);
+    allDirty_ = false;
+}
@@ -0,0 +1,137 @@
+#include <unity.h>
+#include "collisionWorld.hpp"
+#include <vector>
+
+void setUp() {}
+void tearDown() {}
+
+static int countPair(const std::vector<int> &pairs, int a, int b)
+{
+    int n = 0;
+    for (size_t i = 0; i + 1 < pairs.size(); i += 2)
+    {
+        if (pairs[i] == a && pairs[i + 1] == b)
+            ++n;
+    }
+    return n;
+}
+
+static bool contains(const std::vector<int> &ids, int id)
+{
+    for (int i : ids)
+    {
+        if (i == id)
+            return true;
+    }
+    return false;
+}
+
+static void test_small_pair_reported_once()
+{
+    CollisionWorld world(32.0f);
+    int a = world.insertCircle(40, 40, 30, 1, 0xFFFF); // Spans several cells
+    int b = world.insertRect(50, 30, 40, 40, 1, 0xFFFF);
+    world.insertCircle(300, 300, 5, 1, 0xFFFF);
+
+    std::vector<int> pairs;
+    world.collectPairs(pairs);
+    TEST_ASSERT_EQUAL_INT(2, (int)pairs.size());
+    TEST_ASSERT_EQUAL_INT(1, countPair(pairs, a, b));
+}
+
+// A body touching a floor far past the first 32 cells of it
+static void check_long_floor(float cellSize)
+{
+    CollisionWorld world(cellSize);
+    int floor = world.insertRect(0, 200, 2000, 20, 1, 0xFFFF);
+    int body = world.insertCircle(1500, 195, 10, 1, 0xFFFF);
+    world.insertCircle(1500, 100, 10, 1, 0xFFFF); // Above the floor
+
+    std::vector<int> pairs;
+    world.collectPairs(pairs);
+    TEST_ASSERT_EQUAL_INT(2, (int)pairs.size());
+    TEST_ASSERT_EQUAL_INT(1, countPair(pairs, floor, body));
+
+    std::vector<int> ids;
+    world.queryRect(1490, 190, 20, 20, ids);
+    TEST_ASSERT_EQUAL_INT(2, (int)ids.size());
+    TEST_ASSERT_TRUE(contains(ids, floor));
+    TEST_ASSERT_TRUE(contains(ids, body));
+
+    // Moving the body off the floor ends the contact
+    world.move(body, 1500, 150);
+    world.collectPairs(pairs);
+    TEST_ASSERT_EQUAL_INT(0, (int)pairs.size());
+}
+
+static void test_long_floor_default_cells() { check_long_floor(32.0f); }
+static void test_long_floor_small_cells() { check_long_floor(8.0f); }
+
+static void test_wide_query_finds_everything()
+{
+    CollisionWorld world(8.0f);
+    int a = world.insertCircle(10, 10, 4, 1, 0xFFFF);
+    int b = world.insertCircle(1900, 250, 4, 1, 0xFFFF);
+    world.insertCircle(1900, 400, 4, 1, 0xFFFF); // Outside
+
+    std::vector<int> ids;
+    world.queryRect(0, 0, 2000, 300, ids);
+    TEST_ASSERT_EQUAL_INT(2, (int)ids.size());
+    TEST_ASSERT_TRUE(contains(ids, a));
+    TEST_ASSERT_TRUE(contains(ids, b));
+}
+
+static void test_crossing_walls_reported_once()
+{
+    CollisionWorld world(8.0f);
+    int horizontal = world.insertRect(0, 100, 1000, 10, 1, 0xFFFF);
+    int vertical = world.insertRect(500, 0, 10, 1000, 1, 0xFFFF);
+
+    std::vector<int> pairs;
+    world.collectPairs(pairs);
+    TEST_ASSERT_EQUAL_INT(2, (int)pairs.size());
+    TEST_ASSERT_EQUAL_INT(1, countPair(pairs, horizontal, vertical));
+}
+
+static void test_masks_apply_to_large_colliders()
+{
+    CollisionWorld world(32.0f);
+    world.insertRect(0, 200, 2000, 20, 1, 2);
+    world.insertCircle(1500, 195, 10, 4, 0xFFFF); // Category not in the floor's mask
+
+    std::vector<int> pairs;
+    world.collectPairs(pairs);
+    TEST_ASSERT_EQUAL_INT(0, (int)pairs.size());
+}
+
+// Cell coordinates beyond int16 must not wrap onto cells near the origin
+static void test_far_coordinates_do_not_wrap()
+{
+    CollisionWorld world(1.0f);
+    int nearOrigin = world.insertCircle(0, 0, 2, 1, 0xFFFF);
+    int farA = world.insertCircle(65536, 0, 2, 1, 0xFFFF);
+    int farB = world.insertCircle(65537, 0, 2, 1, 0xFFFF);
+
+    std::vector<int> pairs;
+    world.collectPairs(pairs);
+    TEST_ASSERT_EQUAL_INT(2, (int)pairs.size());
+    TEST_ASSERT_EQUAL_INT(1, countPair(pairs, farA, farB));
+
+    std::vector<int> ids;
+    world.queryRect(-1, -1, 2, 2, ids);
+    TEST_ASSERT_EQUAL_INT(1, (int)ids.size());
+    TEST_ASSERT_EQUAL_INT(nearOrigin, ids[0]);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_small_pair_reported_once);
+    RUN_TEST(test_long_floor_default_cells);
+    RUN_TEST(test_long_floor_small_cells);
+    RUN_TEST(test_wide_query_finds_everything);
+    RUN_TEST(test_crossing_walls_reported_once);
+    RUN_TEST(test_masks_apply_to_large_colliders);
+    RUN_TEST(test_far_coordinates_do_not_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,190 @@
+#include <unity.h>
+#include "fixedTransform3d.hpp"
+#include "rasterizer3d.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+void setUp() {}
+void tearDown() {}
+
+static constexpr float FOV = 200.0f;
+static constexpr float CENTER_X = 160.0f;
+static constexpr float CENTER_Y = 120.0f;
+static constexpr float NEAR_Z = 1.0f;
+
+// Depth beyond which the projection must agree with the float path within one subpixel. Closer to the
+// near plane the projection magnifies the Q1.15 rotation error by roughly 1/z^2.
+static constexpr float FAR_FROM_NEAR_Z = 16.0f * NEAR_Z;
+
+static uint32_t rng = 0x2545F491u;
+
+// xorshift32, returns [0, 1)
+static float nextRandom()
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng >> 8) * (1.0f / 16777216.0f);
+}
+
+static float randomRange(float lo, float hi) { return lo + nextRandom() * (hi - lo); }
+
+// Random rotation (from a random unit quaternion) and translation, as the row-major 3x4 FixedTransform3D takes
+static void randomPose(float m[12], float radius)
+{
+    float q[4];
+    float len = 0.0f;
+    do
+    {
+        len = 0.0f;
+        for (int k = 0; k < 4; ++k)
+        {
+            q[k] = randomRange(-1.0f, 1.0f);
+            len += q[k] * q[k];
+        }
+    } while (len < 1e-3f || len > 1.0f);
+
+    len = std::sqrt(len);
+    float w = q[0] / len, x = q[1] / len, y = q[2] / len, z = q[3] / len;
+
+    // In front of the camera and mostly on screen, sometimes right at the near plane
+    float tz = randomRange(NEAR_Z, 250.0f) + radius * randomRange(-1.0f, 1.0f);
+    float tx = randomRange(-0.8f, 0.8f) * tz;
+    float ty = randomRange(-0.6f, 0.6f) * tz;
+
+    float rows[12] = {1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y), tx,
+                      2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x), ty,
+                      2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y), tz};
+    std::copy(rows, rows + 12, m);
+}
+
+static void test_matches_float_projection()
+{
+    int farCompared = 0;
+    int farExact = 0;
+    int worstFar = 0;
+
+    for (int pose = 0; pose < 2000; ++pose)
+    {
+        // The same quantities the renderer passes: int16 positions spanning a sphere of `radius`
+        float radius = randomRange(0.5f, 60.0f);
+        float scale = radius / (32767.0f * 1.7320508f);
+        float m[12];
+        randomPose(m, radius);
+
+        float extent = std::max(std::max(std::fabs(m[3]), std::fabs(m[7])), std::fabs(m[11])) + radius;
+        FixedTransform3D fixed;
+        TEST_ASSERT_TRUE(fixed.setup(m, scale, extent, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+
+        // Float path of the renderer, with the scale folded into the rotation
+        float ms[12];
+        for (int k = 0; k < 12; ++k)
+            ms[k] = (k % 4 == 3) ? m[k] : m[k] * scale;
+
+        for (int i = 0; i < 200; ++i)
+        {
+            int16_t v[3];
+            for (int k = 0; k < 3; ++k)
+                v[k] = (int16_t)std::lround(randomRange(-32767.0f, 32767.0f));
+
+            float camX = ms[0] * v[0] + ms[1] * v[1] + ms[2] * v[2] + ms[3];
+            float camY = ms[4] * v[0] + ms[5] * v[1] + ms[6] * v[2] + ms[7];
+            float camZ = ms[8] * v[0] + ms[9] * v[1] + ms[10] * v[2] + ms[11];
+
+            float cameraZ;
+            int16_t screen[2] = {0, 0};
+            bool projected = fixed.transform(v, cameraZ, screen);
+
+            // Depth is written for every vertex, in Q16.16 from a Q1.15 rotation
+            float depthError = std::fabs(cameraZ - camZ) / extent;
+            TEST_ASSERT_TRUE_MESSAGE(depthError < 1.0f / 4096.0f, "camera depth differs from the float path");
+
+            if (camZ < FAR_FROM_NEAR_Z)
+                continue;
+
+            float sx = camX * (FOV / camZ) + CENTER_X;
+            float sy = camY * (FOV / camZ) + CENTER_Y;
+            if (!Rasterizer3D::inGuardBand(sx, sy))
+                continue;
+
+            // Vertices clear of the guard band's edge must be projected
+            const float inner = Rasterizer3D::GUARD_BAND - 1.0f;
+            if (std::fabs(sx) < inner && std::fabs(sy) < inner)
+                TEST_ASSERT_TRUE_MESSAGE(projected, "vertex inside the guard band was rejected");
+            if (!projected)
+                continue;
+
+            int dx = std::abs(screen[0] - Rasterizer3D::toSubpixel(sx));
+            int dy = std::abs(screen[1] - Rasterizer3D::toSubpixel(sy));
+            worstFar = std::max(worstFar, std::max(dx, dy));
+            farExact += (dx == 0 && dy == 0);
+            ++farCompared;
+        }
+    }
+
+    TEST_ASSERT_GREATER_THAN_INT(100000, farCompared);
+    TEST_ASSERT_LESS_OR_EQUAL_INT(1, worstFar);
+    // Off by one only where the float position lies close to a rounding boundary
+    TEST_ASSERT_GREATER_THAN_INT(farCompared * 9 / 10, farExact);
+}
+
+static void test_near_plane()
+{
+    // Identity rotation, one unit per position step, camera at the origin looking down +Z
+    float m[12] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0};
+    FixedTransform3D fixed;
+    TEST_ASSERT_TRUE(fixed.setup(m, 1.0f / 256.0f, 100.0f, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+
+    float cameraZ = 0.0f;
+    int16_t screen[2] = {123, 456};
+    const int16_t behind[3] = {0, 0, 128}; // z = 0.5
+    TEST_ASSERT_FALSE(fixed.transform(behind, cameraZ, screen));
+    TEST_ASSERT_TRUE(cameraZ == 0.5f);
+    TEST_ASSERT_EQUAL_INT(123, screen[0]);
+    TEST_ASSERT_EQUAL_INT(456, screen[1]);
+
+    const int16_t onPlane[3] = {256, -512, 256}; // (1, -2, 1)
+    TEST_ASSERT_TRUE(fixed.transform(onPlane, cameraZ, screen));
+    TEST_ASSERT_EQUAL_INT(Rasterizer3D::toSubpixel(CENTER_X + FOV), screen[0]);
+    TEST_ASSERT_EQUAL_INT(Rasterizer3D::toSubpixel(CENTER_Y - 2.0f * FOV), screen[1]);
+
+    // Past the guard band at the near plane
+    const int16_t outside[3] = {256 * 20, 0, 256};
+    TEST_ASSERT_FALSE(fixed.transform(outside, cameraZ, screen));
+}
+
+static void test_setup_rejects_what_does_not_fit()
+{
+    float m[12] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 10};
+    FixedTransform3D fixed;
+    TEST_ASSERT_TRUE(fixed.setup(m, 0.001f, 32766.0f, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+
+    // Camera coordinates beyond Q16.16
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.001f, 32767.0f, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.001f, 1e9f, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.001f, NAN, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+
+    // The reciprocal table needs z >= 1
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.001f, 100.0f, FOV, CENTER_X, CENTER_Y, 0.999f));
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.001f, 100.0f, FOV, CENTER_X, CENTER_Y, 0.0f));
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.001f, 100.0f, FOV, CENTER_X, CENTER_Y, NAN));
+
+    // Scale
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.0f, 100.0f, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+    TEST_ASSERT_FALSE(fixed.setup(m, INFINITY, 100.0f, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+    TEST_ASSERT_FALSE(fixed.setup(m, NAN, 100.0f, FOV, CENTER_X, CENTER_Y, NEAR_Z));
+
+    // Field of view
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.001f, 100.0f, 0.0f, CENTER_X, CENTER_Y, NEAR_Z));
+    TEST_ASSERT_FALSE(fixed.setup(m, 0.001f, 100.0f, -200.0f, CENTER_X, CENTER_Y, NEAR_Z));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_float_projection);
+    RUN_TEST(test_near_plane);
+    RUN_TEST(test_setup_rejects_what_does_not_fit);
+    return UNITY_END();
+}